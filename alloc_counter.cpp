@@ -0,0 +1,22 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> allocations{0};
+static std::atomic<size_t> deallocations{0};
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept {
+  if (ptr) deallocations.fetch_add(1, std::memory_order_relaxed);
+  std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+size_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+size_t liveAllocations() { return allocationCount() - deallocations.load(std::memory_order_relaxed); }
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Counters of the replaced global operator new and operator delete. Only the test build links alloc_counter.cpp, the
+ * output binary keeps the default allocator
+ */
+
+/**
+ * Function that returns the number of allocations since the program started
+ * @return number of calls to operator new
+ */
+size_t allocationCount();
+
+/**
+ * Function that returns the number of allocations that were not freed yet
+ * @return calls to operator new minus calls to operator delete with a non-null pointer
+ */
+size_t liveAllocations();
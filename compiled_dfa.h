@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+constexpr size_t STRIDE_TABLE_BUDGET = 64 * 1024;  // largest stride-2 table in bytes that is built automatically
+
+/**
+ * Matcher running a compiled DFA table with the narrowest state ids that fit the number of states. Bytes that no
+ * state tells apart share a class, so a row of the table only has an entry for every class instead of every byte.
+ * When the table for every pair of classes fits the budget, the matcher moves over two bytes with a single lookup,
+ * which halves the chain of lookups that depend on each other
+ */
+template <typename StateId>
+class CompiledDfa {
+  std::array<uint8_t, 256> _classes{};  // class of every byte
+  size_t _num_classes{};
+  std::vector<StateId> _transitions;       // _num_classes entries for every state
+  std::vector<StateId> _pair_transitions;  // _num_classes squared entries for every state, empty if over the budget
+  std::vector<uint8_t> _final_states;
+  StateId _start{};
+  StateId _trap{};
+
+ public:
+  /**
+   * Constructor that narrows a compiled transition table
+   * @param transitions 256 entries for every state, the last state is the trap
+   * @param final_states true for every state that is final
+   * @param start starting state
+   * @param classes class of every byte
+   * @param num_classes number of classes
+   */
+  CompiledDfa(const std::vector<size_t>& transitions, const std::vector<bool>& final_states, size_t start,
+              const std::array<uint8_t, 256>& classes, size_t num_classes)
+      : _classes(classes),
+        _num_classes(num_classes),
+        _final_states(final_states.begin(), final_states.end()),
+        _start(static_cast<StateId>(start)),
+        _trap(static_cast<StateId>(final_states.size() - 1)) {
+    _transitions.resize(final_states.size() * num_classes);
+    for (size_t state = 0; state < final_states.size(); ++state) {
+      for (size_t symbol = 0; symbol < 256; ++symbol) {
+        _transitions[state * num_classes + classes[symbol]] = static_cast<StateId>(transitions[state * 256 + symbol]);
+      }
+    }
+
+    auto num_pairs = num_classes * num_classes;
+    if (final_states.size() * num_pairs * sizeof(StateId) > STRIDE_TABLE_BUDGET) return;
+    _pair_transitions.resize(final_states.size() * num_pairs);
+    for (size_t state = 0; state < final_states.size(); ++state) {
+      for (size_t first = 0; first < num_classes; ++first) {
+        auto middle = _transitions[state * num_classes + first];
+        for (size_t second = 0; second < num_classes; ++second) {
+          _pair_transitions[state * num_pairs + first * num_classes + second] =
+              _transitions[middle * num_classes + second];
+        }
+      }
+    }
+  }
+
+  /**
+   * Function that checks if given string is accepted
+   * @param str string to check
+   * @return true, if string can be accepted
+   */
+  [[nodiscard]] bool match(std::string_view str) const {
+    auto state = _start;
+    size_t i = 0;
+    if (!_pair_transitions.empty()) {
+      auto num_pairs = _num_classes * _num_classes;
+      for (; i + 1 < str.size(); i += 2) {
+        auto pair = _classes[static_cast<unsigned char>(str[i])] * _num_classes +
+                    _classes[static_cast<unsigned char>(str[i + 1])];
+        state = _pair_transitions[state * num_pairs + pair];
+        if (state == _trap) return false;
+      }
+    }
+    for (; i < str.size(); ++i) {
+      state = next(state, str[i]);
+      if (state == _trap) return false;
+    }
+    return _final_states[state];
+  }
+
+  /**
+   * Function that returns the state given state moves to, for searches that have to look at every state on the way
+   * @param state state of the matcher
+   * @param symbol byte of the input
+   * @return state, the trap state if there is no transition
+   */
+  [[nodiscard]] StateId next(StateId state, char symbol) const {
+    return _transitions[state * _num_classes + _classes[static_cast<unsigned char>(symbol)]];
+  }
+
+  [[nodiscard]] StateId getStart() const { return _start; }
+  [[nodiscard]] StateId getTrap() const { return _trap; }
+  [[nodiscard]] bool isFinal(StateId state) const { return _final_states[state]; }
+
+  [[nodiscard]] size_t getClassCount() const { return _num_classes; }
+  [[nodiscard]] size_t getTableSize() const { return _transitions.size() * sizeof(StateId); }
+  [[nodiscard]] size_t getPairTableSize() const { return _pair_transitions.size() * sizeof(StateId); }
+};
+
+typedef std::variant<CompiledDfa<uint8_t>, CompiledDfa<uint16_t>, CompiledDfa<uint32_t>> CompiledMatcher;
+
+/**
+ * Function that compiles a transition table into a matcher with the narrowest state ids that fit all states
+ * @param transitions 256 entries for every state, the last state is the trap
+ * @param final_states true for every state that is final
+ * @param start starting state
+ * @return matcher
+ */
+inline CompiledMatcher compileMatcher(const std::vector<size_t>& transitions, const std::vector<bool>& final_states,
+                                      size_t start) {
+  // bytes get the same class when every state moves to the same target on them, the classes are refined one state at
+  // a time by sorting the bytes on their class so far and their target. Rows that move every class to a single target
+  // split nothing and skip the sort, which are almost all rows of a large DFA
+  std::array<uint8_t, 256> classes{};
+  std::array<size_t, 256> bytes;
+  std::array<size_t, 256> targets;
+  size_t num_classes = 1;
+  for (size_t state = 0; state < final_states.size() && num_classes < 256; ++state) {
+    const auto* row = transitions.data() + state * 256;
+    targets.fill(static_cast<size_t>(-1));
+    bool splits = false;
+    for (size_t byte = 0; byte < 256 && !splits; ++byte) {
+      auto& target = targets[classes[byte]];
+      if (target == static_cast<size_t>(-1)) target = row[byte];
+      splits = target != row[byte];
+    }
+    if (!splits) continue;
+    std::iota(bytes.begin(), bytes.end(), 0);
+    std::sort(bytes.begin(), bytes.end(), [&classes, row](size_t a, size_t b) {
+      return std::tuple(classes[a], row[a], a) < std::tuple(classes[b], row[b], b);
+    });
+    std::array<uint8_t, 256> refined{};
+    num_classes = 1;
+    for (size_t i = 1; i < 256; ++i) {
+      auto previous = bytes[i - 1];
+      if (classes[bytes[i]] != classes[previous] || row[bytes[i]] != row[previous]) num_classes++;
+      refined[bytes[i]] = static_cast<uint8_t>(num_classes - 1);
+    }
+    classes = refined;
+  }
+
+  auto states = final_states.size();
+  if (states <= std::numeric_limits<uint8_t>::max() + size_t{1}) {
+    return CompiledDfa<uint8_t>(transitions, final_states, start, classes, num_classes);
+  }
+  if (states <= std::numeric_limits<uint16_t>::max() + size_t{1}) {
+    return CompiledDfa<uint16_t>(transitions, final_states, start, classes, num_classes);
+  }
+  return CompiledDfa<uint32_t>(transitions, final_states, start, classes, num_classes);
+}
@@ -1,48 +1,55 @@
 #include "dfa.h"
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <numeric>
+
+#include "literals.h"
+
+/**
+ * Function that returns a new id for a numbering of compiled states, unique among all DFAs
+ * @return id
+ */
+static size_t nextLayout() {
+  static std::atomic<size_t> layouts{0};
+  return ++layouts;
+}
+
 DfaState DfaState::move(const char& symbol) {
   DfaState state;
   for (const auto& node : _nodes) {
-    if (!node->isEpsilon() && node->getSymbol() == symbol) {
-      state._nodes.insert(node->getLeft());
+    if (node->hasTransitionOn(symbol)) {
+      state.insert(node->getLeft());
     }
   }
-
-  _possible_moves.emplace_back(symbol, state.epsilonClosure().getIds());
+  state.epsilonClosure();
   return state;
 }
-bool DFA::containsState(const DfaState& state) {
-  for (const auto& it : _all) {
-    if (it->getIds() == state.getIds()) return true;
-  }
-  return false;
-}
+void DfaState::addMove(char symbol, const DfaState* target) { _possible_moves.emplace_back(symbol, target); }
 bool DfaState::isFinal() const { return _is_final; }
 void DfaState::setFinal(bool val) { _is_final = val; }
-char DfaState::getName() const { return _state_name; }
-void DfaState::setName(char val) { _state_name = val; }
-DfaState DfaState::epsilonClosure() {
-  DfaState state = *this;
-  while (true) {
-    DfaState temp = state;
-    for (const auto& node : state._nodes) {
-      if (node == nullptr) continue;
-
-      if (node->isEpsilon()) {
-        state._nodes.insert(node->getLeft());
-        if (node->getRight()) state._nodes.insert(node->getRight());
-      }
-    }
-    if (temp._nodes.size() == state._nodes.size()) break;
+void DfaState::epsilonClosure() {
+  std::vector<NfaNode*> stack;
+  for (const auto& node : _nodes) {
+    stack.push_back(node.get());
+  }
+  while (!stack.empty()) {
+    auto* node = stack.back();
+    stack.pop_back();
+    if (!node->isEpsilon()) continue;
+    if (insert(node->getLeft())) stack.push_back(node->getLeft().get());
+    if (insert(node->getRight())) stack.push_back(node->getRight().get());
   }
-  return state;
 }
-std::set<char> DfaState::possibleMoves() {
-  std::set<char> moves;
+std::bitset<256> DfaState::possibleMoves() const {
+  std::bitset<256> moves;
   for (const auto& node : _nodes) {
-    if (node == nullptr) continue;
     if (!node->isEpsilon() && node->getLeft() != nullptr) {
-      moves.insert(node->getSymbol());
+      for (int symbol = static_cast<unsigned char>(node->getSymbol());
+           symbol <= static_cast<unsigned char>(node->getLastSymbol()); ++symbol) {
+        moves.set(symbol);
+      }
     }
   }
   return moves;
@@ -58,128 +65,374 @@ void DfaState::printIds() const {
   }
   std::cout << " }";
 }
-std::set<size_t> DfaState::getIds() const {
-  std::set<size_t> ids;
-  for (const auto& state : _nodes) {
-    ids.insert(state->getId());
-  }
-  return ids;
+bool DfaState::insert(const SPNfaNode& node) {
+  if (node == nullptr || !_nodes.insert(node).second) return false;
+  _ids.insert(node->getId());
+  return true;
 }
-bool DfaState::insert(const SPNfaNode& node) { return _nodes.insert(node).second; }
-std::vector<std::pair<char, std::set<size_t>>> DfaState::getMoves() const { return _possible_moves; }
-void DFA::insert(const SPDfaState& state) {
-  *state = state->epsilonClosure();
-  if (containsState(*state)) return;
-  _all.insert(state);
-  state->setName(_current_name++);
-  if (state->contains(_final_node)) {
-    state->setFinal(true);
-  }
-  auto moves = state->possibleMoves();
-  _all_moves.insert(moves.begin(), moves.end());
-  for (const auto& symbol : moves) {
-    auto move_state = state->move(symbol);
-    if (!containsState(move_state)) {
-      insert(std::make_shared<DfaState>(move_state));
+const DfaState* DFA::insert(const SPDfaState& state) {
+  auto [it, inserted] = _states.try_emplace(state->getIds(), state);
+  if (!inserted) return it->second.get();
+  // new states wait in a worklist until their moves are known, recursing instead would overflow the stack on DFAs with
+  // tens of thousands of states
+  std::vector<DfaState*> pending{state.get()};
+  while (!pending.empty()) {
+    auto* current = pending.back();
+    pending.pop_back();
+    if (current->contains(_final_node)) {
+      current->setFinal(true);
+    }
+    auto moves = current->possibleMoves();
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      if (!moves.test(symbol)) continue;
+      auto move_state = current->move(static_cast<char>(symbol));
+      auto existing = _states.find(move_state.getIds());
+      if (existing == _states.end()) {
+        auto ids = move_state.getIds();
+        existing = _states.emplace(std::move(ids), std::make_shared<DfaState>(std::move(move_state))).first;
+        pending.push_back(existing->second.get());
+      }
+      current->addMove(static_cast<char>(symbol), existing->second.get());
     }
   }
-}
-char DFA::getStateName(const std::set<size_t>& ids) {
-  for (const auto& state : _all) {
-    if (ids == state->getIds()) return state->getName();
-  }
-  return ' ';
+  return state.get();
 }
 DFA DFA::generateDfaFromNfa(const NfaStructure& nfa) {
   DFA dfa;
-  if (nfa.getStart() == nullptr) return dfa;
+  if (nfa.getStart() == nullptr) {
+    dfa.compile();
+    return dfa;
+  }
   dfa._final_node = nfa.getFinal();
   auto temp = std::make_shared<DfaState>();
   temp->insert(nfa.getStart());
-  *temp = temp->epsilonClosure();
+  temp->epsilonClosure();
   dfa._start = std::move(temp);
   dfa.insert(dfa._start);
+  dfa.compile();
+  // the states of the subset construction hold the NFA nodes, and aren't needed once the table is compiled
+  dfa._states.clear();
+  dfa._start = nullptr;
+  dfa._final_node = nullptr;
   return dfa;
 }
 ErrOr<DFA> DFA::generateDfaFromRE(const std::string& expression, bool print) {
-  auto nfa = NfaStructure::generateNfaFromRE(expression, print);
+  RegExpParser parser;
+  auto parsed = parser.parseExpression(expression);
+  if (parsed.err) {
+    return *parsed.err;
+  }
+  std::vector<std::string> literals;
+  if (!print && LiteralSearcher::extractLiterals(parsed.data.value().second, literals)) {
+    return generateDfaFromLiterals(literals);
+  }
+  auto nfa = print ? NfaStructure::generateNfaFromRE(expression, print)
+                   : NfaStructure::generateNfaFromExpression(parsed.data.value().second);
   if (nfa.err) {
     return *nfa.err;
   }
   if (print) (*nfa.data).print();
-  return generateDfaFromNfa(nfa.data.value());
+  auto dfa = generateDfaFromNfa(nfa.data.value());
+  (*nfa.data).releaseNodes();
+  return dfa;
 }
-void DFA::print() {
-  std::cout << "Printing DFA transition table\nIn the first row, all possible moves are printed\nIn the first column "
-               "all states are listed. State A "
-               "is the starting state, and all states written with color "
-            << RED << "red" << RESET << " are the final states\n\n";
-  bool trap_state = false;
-  std::cout << "   |";
-  for (const auto& val : _all_moves) {
-    std::cout << " " << YELLOW << val << RESET << " |";
-  }
-  std::cout << std::endl;
-  std::cout << "---|";
-  for (const auto& val : _all_moves) {
-    std::cout << "---|";
-  }
-  std::cout << std::endl;
-  for (const auto& state : _all) {
-    if (state->isFinal()) {
-      std::cout << " " << RED << state->getName() << RESET << " |";
-    } else {
-      std::cout << " " << YELLOW << state->getName() << RESET << " |";
+ErrOr<DFA> DFA::generateReverseDfaFromRE(const std::string& expression, bool print) {
+  auto nfa = NfaStructure::generateNfaFromRE(expression, print);
+  if (nfa.err) {
+    return *nfa.err;
+  }
+  auto reversed = (*nfa.data).reverse();
+  if (print) reversed.print();
+  auto dfa = generateDfaFromNfa(reversed);
+  reversed.releaseNodes();
+  (*nfa.data).releaseNodes();
+  return dfa;
+}
+void DFA::compile() {
+  // states are numbered in the order of the breadth first search from the starting state
+  std::map<const DfaState*, size_t> numbers;
+  std::vector<const DfaState*> states;
+  if (_start) {
+    numbers[_start.get()] = 0;
+    states.push_back(_start.get());
+  }
+  for (size_t i = 0; i < states.size(); ++i) {
+    for (const auto& move : states[i]->getMoves()) {
+      if (numbers.try_emplace(move.second, states.size()).second) states.push_back(move.second);
     }
+  }
 
-    for (const auto& val : _all_moves) {
-      bool was_set = false;
-      for (const auto& mv : state->getMoves()) {
-        if (mv.first == val) {
-          std::cout << " " << getStateName(mv.second) << " |";
-          was_set = true;
-          break;
-        }
+  auto trap = states.size();
+  _transitions.assign((states.size() + 1) * 256, trap);
+  _final_states.assign(states.size() + 1, false);
+  for (size_t i = 0; i < states.size(); ++i) {
+    _final_states[i] = states[i]->isFinal();
+    for (const auto& move : states[i]->getMoves()) {
+      _transitions[i * 256 + static_cast<unsigned char>(move.first)] = numbers[move.second];
+    }
+  }
+  _start_state = _start ? 0 : trap;
+  _layout = nextLayout();
+  _matcher = compileMatcher(_transitions, _final_states, _start_state);
+}
+DFA DFA::generateDfaFromLiterals(const std::vector<std::string>& literals) {
+  std::vector<size_t> transitions(256, npos);
+  std::vector<bool> final_states{false};
+  for (const auto& literal : literals) {
+    size_t state = 0;
+    for (const auto& symbol : literal) {
+      auto& next = transitions[state * 256 + static_cast<unsigned char>(symbol)];
+      if (next == npos) {
+        next = final_states.size();
+        final_states.push_back(false);
+        transitions.resize(transitions.size() + 256, npos);
       }
-      if (!was_set) {
-        trap_state = true;
-        std::cout << " " << _current_name << " |";
+      state = transitions[state * 256 + static_cast<unsigned char>(symbol)];
+    }
+    final_states[state] = true;
+  }
+  // missing transitions of the trie go to the trap state, numbering the states is left to generateDfaFromTable
+  auto trap = final_states.size();
+  std::replace(transitions.begin(), transitions.end(), npos, trap);
+  transitions.resize(transitions.size() + 256, trap);
+  final_states.push_back(false);
+  auto dfa = generateDfaFromTable(transitions, final_states, 0);
+  dfa._literals.insert(literals.begin(), literals.end());
+  return dfa;
+}
+DFA DFA::generateDfaFromTable(const std::vector<size_t>& transitions, const std::vector<bool>& final_states,
+                              size_t start) {
+  // live states are the ones a final state can be reached from, found by searching backwards from the final states
+  auto count = final_states.size();
+  std::vector<std::vector<size_t>> predecessors(count);
+  for (size_t state = 0; state < count; ++state) {
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      predecessors[transitions[state * 256 + symbol]].push_back(state);
+    }
+  }
+  std::vector<bool> live(final_states);
+  std::vector<size_t> stack;
+  for (size_t state = 0; state < count; ++state) {
+    if (live[state]) stack.push_back(state);
+  }
+  while (!stack.empty()) {
+    auto state = stack.back();
+    stack.pop_back();
+    for (const auto& predecessor : predecessors[state]) {
+      if (live[predecessor]) continue;
+      live[predecessor] = true;
+      stack.push_back(predecessor);
+    }
+  }
+
+  std::vector<size_t> numbers(count, npos);
+  std::vector<size_t> states;
+  if (live[start]) {
+    numbers[start] = 0;
+    states.push_back(start);
+  }
+  for (size_t i = 0; i < states.size(); ++i) {
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      auto target = transitions[states[i] * 256 + symbol];
+      if (!live[target] || numbers[target] != npos) continue;
+      numbers[target] = states.size();
+      states.push_back(target);
+    }
+  }
+
+  DFA dfa;
+  auto trap = states.size();
+  dfa._transitions.assign((states.size() + 1) * 256, trap);
+  dfa._final_states.assign(states.size() + 1, false);
+  for (size_t i = 0; i < states.size(); ++i) {
+    dfa._final_states[i] = final_states[states[i]];
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      auto target = numbers[transitions[states[i] * 256 + symbol]];
+      if (target != npos) dfa._transitions[i * 256 + symbol] = target;
+    }
+  }
+  dfa._start_state = states.empty() ? trap : 0;
+  dfa._layout = nextLayout();
+  dfa._matcher = compileMatcher(dfa._transitions, dfa._final_states, dfa._start_state);
+  return dfa;
+}
+DFA DFA::generateProductDfa(const DFA& first, const DFA& second, ProductOperation operation) {
+  std::map<std::pair<size_t, size_t>, size_t> numbers;
+  std::vector<std::pair<size_t, size_t>> states = {{first._start_state, second._start_state}};
+  numbers[states.front()] = 0;
+  std::vector<size_t> transitions;
+  std::vector<bool> final_states;
+  for (size_t i = 0; i < states.size(); ++i) {
+    auto [left, right] = states[i];
+    switch (operation) {
+      case ProductOperation::Intersection: {
+        final_states.push_back(first.isFinalState(left) && second.isFinalState(right));
+        break;
+      }
+      case ProductOperation::Union: {
+        final_states.push_back(first.isFinalState(left) || second.isFinalState(right));
+        break;
+      }
+      case ProductOperation::Difference: {
+        final_states.push_back(first.isFinalState(left) && !second.isFinalState(right));
+        break;
       }
     }
-    std::cout << std::endl;
-    std::cout << "---|";
-    for (const auto& val : _all_moves) {
-      std::cout << "---|";
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      std::pair<size_t, size_t> target = {first.nextState(left, static_cast<char>(symbol)),
+                                          second.nextState(right, static_cast<char>(symbol))};
+      auto [it, inserted] = numbers.try_emplace(target, states.size());
+      if (inserted) states.push_back(target);
+      transitions.push_back(it->second);
     }
-    std::cout << std::endl;
   }
-  if (trap_state) {
-    std::cout << " " << _current_name << " |";
-    for (const auto& val : _all_moves) {
-      std::cout << " " << _current_name << " |";
+  return generateDfaFromTable(transitions, final_states, 0);
+}
+DFA DFA::generateComplementDfa(const DFA& dfa) {
+  // the trap state becomes final as well, so the complement accepts every string that leaves the original DFA
+  auto final_states = dfa._final_states;
+  final_states.flip();
+  return generateDfaFromTable(dfa._transitions, final_states, dfa._start_state);
+}
+DfaProfile DFA::profile(const std::vector<std::string>& corpus) const {
+  DfaProfile profile{_layout, std::vector<size_t>(_final_states.size(), 0),
+                     std::vector<size_t>(_transitions.size(), 0)};
+  for (const auto& str : corpus) {
+    auto state = _start_state;
+    profile.visits[state]++;
+    for (const auto& symbol : str) {
+      profile.transitions[state * 256 + static_cast<unsigned char>(symbol)]++;
+      state = nextState(state, symbol);
+      profile.visits[state]++;
+      if (state == getTrapState()) break;
     }
-    std::cout << std::endl;
-    std::cout << "---|";
-    for (const auto& val : _all_moves) {
-      std::cout << "---|";
+  }
+  return profile;
+}
+OErr DFA::reorderStates(const DfaProfile& profile) {
+  // a profile of the same DFA taken before an earlier reordering has the right sizes, but counts the old numbering
+  if (profile.layout != _layout) {
+    return ERROR_WITH_FILE("profile was taken on another numbering of the states");
+  }
+  auto trap = getTrapState();
+  std::vector<size_t> by_visits(trap);
+  std::iota(by_visits.begin(), by_visits.end(), 0);
+  std::stable_sort(by_visits.begin(), by_visits.end(),
+                   [&profile](size_t a, size_t b) { return profile.visits[a] > profile.visits[b]; });
+
+  std::vector<size_t> order;
+  std::vector<bool> placed(trap + 1, false);
+  placed[trap] = true;
+  for (const auto& head : by_visits) {
+    for (auto state = head; !placed[state];) {
+      placed[state] = true;
+      order.push_back(state);
+      // the chain continues with the target of the most used transition, the trap state ends it
+      auto next = trap;
+      size_t uses = 0;
+      for (size_t symbol = 0; symbol < 256; ++symbol) {
+        auto target = _transitions[state * 256 + symbol];
+        if (placed[target] || profile.transitions[state * 256 + symbol] <= uses) continue;
+        uses = profile.transitions[state * 256 + symbol];
+        next = target;
+      }
+      state = next;
     }
-    std::cout << "\n";
   }
-  std::cout << "\n";
+
+  std::vector<size_t> numbers(trap + 1, trap);
+  for (size_t i = 0; i < order.size(); ++i) {
+    numbers[order[i]] = i;
+  }
+  std::vector<size_t> transitions(_transitions.size());
+  std::vector<bool> final_states(_final_states.size(), false);
+  for (size_t state = 0; state <= trap; ++state) {
+    auto number = numbers[state];
+    final_states[number] = _final_states[state];
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      transitions[number * 256 + symbol] = numbers[_transitions[state * 256 + symbol]];
+    }
+  }
+  _transitions = std::move(transitions);
+  _final_states = std::move(final_states);
+  _start_state = numbers[_start_state];
+  _layout = nextLayout();
+  _matcher = compileMatcher(_transitions, _final_states, _start_state);
+  return std::nullopt;
 }
+/**
+ * Function that returns the printed name of a compiled state, letters like spreadsheet columns: A to Z, AA, AB...
+ * @param state compiled state
+ * @return name of the state
+ */
+static std::string stateName(size_t state) {
+  std::string name;
+  for (auto i = state + 1; i > 0; i = (i - 1) / 26) {
+    name.insert(name.begin(), static_cast<char>('A' + (i - 1) % 26));
+  }
+  return name;
+}
+void DFA::print() const {
+  auto trap = getTrapState();
+  // bytes moving every state to the same target share a column, columns where every state moves to the trap are
+  // left out
+  std::vector<std::pair<size_t, size_t>> columns;
+  auto same_column = [this, trap](size_t first, size_t second) {
+    for (size_t state = 0; state <= trap; ++state) {
+      if (nextState(state, static_cast<char>(first)) != nextState(state, static_cast<char>(second))) return false;
+    }
+    return true;
+  };
+  for (size_t symbol = 0; symbol < 256; ++symbol) {
+    if (!columns.empty() && columns.back().second + 1 == symbol && same_column(columns.back().first, symbol)) {
+      columns.back().second = symbol;
+    } else {
+      columns.emplace_back(symbol, symbol);
+    }
+  }
+  std::erase_if(columns, [this, trap](const auto& column) {
+    for (size_t state = 0; state < trap; ++state) {
+      if (nextState(state, static_cast<char>(column.first)) != trap) return false;
+    }
+    return true;
+  });
 
-bool DFA::parseExpression(const std::string& expression) { return parseExpression(expression, _start); }
+  std::vector<std::string> labels;
+  auto width = stateName(trap).size();
+  for (const auto& [first, last] : columns) {
+    auto label = printableByte(static_cast<char>(first));
+    if (last != first) label += "-" + printableByte(static_cast<char>(last));
+    width = std::max(width, label.size());
+    labels.push_back(std::move(label));
+  }
+  auto cell = [width](const std::string& text) { return text + std::string(width - text.size(), ' ') + " |"; };
+  std::string separator = std::string(width + 2, '-') + "|";
+  for (size_t i = 0; i < columns.size(); ++i) {
+    separator += std::string(width + 2, '-') + "|";
+  }
 
-bool DFA::parseExpression(std::string expression, const SPDfaState& state) {
-  if (expression.empty()) return state->isFinal();
-  auto curr = expression.at(0);
-  for (const auto& move : state->getMoves()) {
-    if (move.first == curr) {
-      expression.erase(0, 1);
-      for (const auto& temp : _all) {
-        if (temp->getIds() == move.second) return parseExpression(expression, temp);
-      }
+  std::cout << "Printing DFA transition table\nIn the first row, all possible moves are printed\nIn the first column "
+               "all states are listed. State "
+            << stateName(_start_state) << " is the starting state, state " << stateName(trap)
+            << " is the trap state, and all states written with color " << RED << "red" << RESET
+            << " are the final states\n\n";
+  std::cout << " " << cell("");
+  for (const auto& label : labels) {
+    std::cout << " " << YELLOW << label << RESET << cell(label).substr(label.size());
+  }
+  std::cout << "\n" << separator << "\n";
+  for (size_t state = 0; state <= trap; ++state) {
+    auto name = stateName(state);
+    std::cout << " " << (isFinalState(state) ? RED : YELLOW) << name << RESET << cell(name).substr(name.size());
+    for (const auto& column : columns) {
+      std::cout << " " << cell(stateName(nextState(state, static_cast<char>(column.first))));
     }
+    std::cout << "\n" << separator << "\n";
   }
-  return false;
+  std::cout << "\n";
+}
+
+bool DFA::parseExpression(const std::string& expression) const {
+  if (!_literals.empty()) return _literals.contains(expression);
+  return std::visit([&expression](const auto& matcher) { return matcher.match(expression); }, *_matcher);
 }
@@ -1,42 +1,44 @@
 #pragma once
+#include <bitset>
+#include <map>
 #include <set>
+#include <unordered_set>
 #include <vector>
 
+#include "compiled_dfa.h"
 #include "errors.h"
 #include "nfa.h"
 class DfaState {
   std::set<SPNfaNode> _nodes;  // set of all NFA nodes that this state is made of
-  std::vector<std::pair<char, std::set<size_t>>>
-      _possible_moves;    // vector containing all possible characters and a set of ids that the transition will move to
+  std::set<size_t> _ids;       // ids of the NFA nodes, kept next to them so states are compared without rebuilding it
+  std::vector<std::pair<char, const DfaState*>>
+      _possible_moves;    // vector containing all possible characters and the state that the transition will move to
   bool _is_final{false};  // set to true if that state is a final state
-  char _state_name{' '};  // character representing the name of the node
 
  public:
   DfaState() = default;
 
   [[nodiscard]] bool isFinal() const;
   void setFinal(bool val);
-  [[nodiscard]] char getName() const;
-  void setName(char val);
 
   /**
-   * Function that returns a DFA state consisting of all the nodes, that this state can move to, using given symbol
+   * Function that returns a DFA state consisting of all the nodes, that this state can move to, using given symbol,
+   * and their epsilon closure
    * @param symbol character representing the symbol of transition
    * @return DfaState state consisting of all the nodes, that this state can move to
    */
   DfaState move(const char& symbol);
 
   /**
-   * Function that performs epsilonClosure for a DfaState
-   * @return DfaState state representing epsilon closure of this state
+   * Function that performs epsilonClosure for a DfaState, adding the nodes to this state
    */
-  DfaState epsilonClosure();
+  void epsilonClosure();
 
   /**
    * Function that shows all possible moves for this state
-   * @return set of all characters, that are a possible move for NFA nodes of this state
+   * @return bit for every byte, set if the byte is a possible move for NFA nodes of this state
    */
-  std::set<char> possibleMoves();
+  [[nodiscard]] std::bitset<256> possibleMoves() const;
 
   /**
    * Function that checks is this state contains given node
@@ -54,7 +56,7 @@ class DfaState {
    * Function that returns a set of all NFA nodes ids contained by this state
    * @return std::set<size_t> of NFA ids
    */
-  [[nodiscard]] std::set<size_t> getIds() const;
+  [[nodiscard]] const std::set<size_t>& getIds() const { return _ids; }
 
   /**
    * Function that inserts a node to the state
@@ -63,45 +65,76 @@ class DfaState {
    */
   bool insert(const SPNfaNode& node);
 
+  /**
+   * Function that adds a transition of this state
+   * @param symbol character representing the symbol of transition
+   * @param target state the transition moves to, owned by the DFA
+   */
+  void addMove(char symbol, const DfaState* target);
+
   /**
    * Function that returns the _possible_moves member
    * @return _possible_moves
    */
-  [[nodiscard]] std::vector<std::pair<char, std::set<size_t>>> getMoves() const;
+  [[nodiscard]] const std::vector<std::pair<char, const DfaState*>>& getMoves() const { return _possible_moves; }
 };
 
 typedef std::shared_ptr<DfaState> SPDfaState;
 
+enum class ProductOperation { Intersection, Union, Difference };
+
+/**
+ * Counts of a profiling run of a compiled DFA
+ */
+struct DfaProfile {
+  size_t layout{0};                 // numbering of the states the profile was taken on
+  std::vector<size_t> visits;       // visits of every compiled state
+  std::vector<size_t> transitions;  // uses of every transition, 256 entries for every state like the compiled table
+};
+
 class DFA {
   SPDfaState _start;
   SPNfaNode _final_node;
-  std::set<SPDfaState> _all;
-  std::set<char> _all_moves;
-  char _current_name = 'A';
+  std::map<std::set<size_t>, SPDfaState> _states;  // all states by the ids of their NFA nodes
+  std::vector<size_t> _transitions;  // compiled transition table, 256 entries for every state, last state is the trap
+  std::vector<bool> _final_states;   // true for every compiled state that is final
+  size_t _start_state{0};
+  size_t _layout{0};  // id of the numbering of the compiled states, new whenever the table is built or reordered
+  std::optional<CompiledMatcher> _matcher;  // narrow copy of the compiled table used by parseExpression
+  std::unordered_set<std::string> _literals;  // strings accepted, if the DFA was generated from literals only
 
   DFA() = default;
 
   /**
-   * Function that checks if given state is in the DFA
-   * @param state DFA state
-   * @return true if state exists in the DFA
+   * Function that numbers all states and fills the compiled transition table
    */
-  bool containsState(const DfaState& state);
+  void compile();
 
   /**
-   * Function that inserts a state to the DFA
+   * Function that inserts a state to the DFA, together with all states it moves to
    * @param state shared pointer to a DFA state
-   * @return true if node was inserted, false if the node was already contained by the state
+   * @return the state of the DFA with the same NFA nodes, which is given state if it was not in the DFA yet
+   */
+  const DfaState* insert(const SPDfaState& state);
+
+  /**
+   * Function that generates a DFA from a transition table, states that can't reach a final state are merged into the
+   * trap state and states that can't be reached are dropped
+   * @param transitions 256 entries for every state
+   * @param final_states true for every state that is final
+   * @param start starting state
+   * @return DFA with states numbered in breadth first order and the trap state last
    */
-  void insert(const SPDfaState& state);
+  static DFA generateDfaFromTable(const std::vector<size_t>& transitions, const std::vector<bool>& final_states,
+                                  size_t start);
 
   /**
-   * Function that returns the name of the state
-   * @param ids sts::set of NFA node ids
-   * @return name of the state
+   * Function that generates a DFA from the trie of literals, without building a NFA and running the subset
+   * construction
+   * @param literals strings the DFA accepts
+   * @return DFA, matching with a lookup in the set of literals
    */
-  char getStateName(const std::set<size_t>& ids);
-  bool parseExpression(std::string expression, const SPDfaState& state);
+  static DFA generateDfaFromLiterals(const std::vector<std::string>& literals);
 
  public:
   /**
@@ -112,18 +145,79 @@ class DFA {
   static DFA generateDfaFromNfa(const NfaStructure& nfa);
 
   /**
-   * Function that generates a DFA from a string
+   * Function that generates a DFA from a string. An expression that is only an alternation of literals, like
+   * 123|abc|bba, is generated from the literals directly, unless the steps are printed
    * @param expression string with the expression
    * @return DFA or error
    */
   static ErrOr<DFA> generateDfaFromRE(const std::string& expression, bool print = false);
 
-  void print();
+  /**
+   * Function that generates a DFA accepting the reversed strings accepted by an expression
+   * @param expression string with the expression
+   * @return DFA or error
+   */
+  static ErrOr<DFA> generateReverseDfaFromRE(const std::string& expression, bool print = false);
+
+  /**
+   * Function that generates the product of two DFAs, which reads the input once for both of them
+   * @param first DFA
+   * @param second DFA
+   * @param operation which strings the product accepts: accepted by both, by any, or by first but not by second
+   * @return DFA
+   */
+  static DFA generateProductDfa(const DFA& first, const DFA& second, ProductOperation operation);
+
+  /**
+   * Function that generates a DFA accepting exactly the strings that a DFA rejects
+   * @param dfa DFA
+   * @return DFA
+   */
+  static DFA generateComplementDfa(const DFA& dfa);
+
+  /**
+   * Function that prints the compiled transition table, bytes with the same moves share a column
+   */
+  void print() const;
 
   /**
    * Function that checks if given string is accepted by the DFA
    * @param expression string with the expression
    * @return true, if string can be accepted
    */
-  bool parseExpression(const std::string& expression);
+  [[nodiscard]] bool parseExpression(const std::string& expression) const;
+
+  /**
+   * Function that runs the compiled DFA over sample strings and counts how often every state is visited and every
+   * transition is taken
+   * @param corpus sample strings, for example taken from real traffic
+   * @return visits and transitions, for every compiled state including the trap state
+   */
+  [[nodiscard]] DfaProfile profile(const std::vector<std::string>& corpus) const;
+
+  /**
+   * Function that renumbers the compiled states from a profile, so hot rows of the transition table sit next to each
+   * other. Starting from the most visited state, each state is followed by the target of its most used transition
+   * that is not placed yet, and when that chain ends the most visited remaining state starts the next one. States the
+   * profile never reached keep the breadth first order, and the trap state stays last
+   * @param profile profile of this DFA, as returned by profile
+   * @return error if the profile was taken on another DFA, or before the states were reordered
+   */
+  OErr reorderStates(const DfaProfile& profile);
+
+  [[nodiscard]] const CompiledMatcher& getMatcher() const { return *_matcher; }
+  [[nodiscard]] bool isLiteralSet() const { return !_literals.empty(); }
+  [[nodiscard]] size_t getStartState() const { return _start_state; }
+  [[nodiscard]] size_t getTrapState() const { return _final_states.size() - 1; }
+  [[nodiscard]] bool isFinalState(size_t state) const { return _final_states[state]; }
+
+  /**
+   * Function that returns the compiled state that given state moves to
+   * @param state compiled state
+   * @param symbol byte of the input
+   * @return compiled state, the trap state if there is no transition
+   */
+  [[nodiscard]] size_t nextState(size_t state, char symbol) const {
+    return _transitions[state * 256 + static_cast<unsigned char>(symbol)];
+  }
 };
@@ -0,0 +1,381 @@
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <regex>
+#include <sstream>
+
+#include "dfa.h"
+
+// every corpus line is a pattern, an input and a note, separated by tabs
+const std::string CORPUS_FILE = "differential_corpus.txt";
+const std::string ALPHABET = "ab01-";
+constexpr double COMPILE_CLIFF_MS = 50.0;  // compile time above which a pattern is reported as a performance cliff
+constexpr double MATCH_CLIFF_RATIO = 100.0;  // how many times slower than std::regex a match has to be to be reported
+constexpr double MATCH_CLIFF_MS = 1.0;  // matches faster than that are never reported as performance cliffs
+constexpr double MIN_TIMED_MS = 0.1;    // a match is repeated until it ran at least that long, hiding the timer cost
+constexpr int REGEX_TIMEOUT_MS = 250;   // how long std::regex may take on a single input before it is skipped
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * Result of a match and the time a single run of it took
+ */
+struct TimedMatch {
+  bool result;
+  double ms;
+};
+
+/**
+ * Function that times a match, repeating it with twice the runs until all runs together take at least MIN_TIMED_MS,
+ * so the cost of reading the clock doesn't show in the time of a short input
+ * @param match function running the match
+ * @return result of the match and the time of a single run
+ */
+template <typename Match>
+TimedMatch timeMatch(const Match& match) {
+  for (size_t repeats = 1;; repeats *= 2) {
+    bool result = false;
+    auto start = Clock::now();
+    for (size_t i = 0; i < repeats; ++i) {
+      result = match();
+    }
+    auto ms = millisecondsSince(start);
+    if (ms >= MIN_TIMED_MS) return {result, ms / repeats};
+  }
+}
+
+/**
+ * Node of a randomly generated pattern, kept so strings accepted by the pattern can be sampled from it
+ */
+struct PatternNode {
+  ExprssionType type;
+  char value{};
+  std::vector<PatternNode> children;
+
+  [[nodiscard]] std::string toString() const {
+    switch (type) {
+      case ExprssionType::Value:
+        return std::string(1, value);
+      case ExprssionType::Add:
+        return children[0].toString() + children[1].toString();
+      case ExprssionType::Or:
+        return children[0].toString() + "|" + children[1].toString();
+      case ExprssionType::Star:
+        return children[0].toString() + "*";
+      case ExprssionType::Brackets:
+        return "(" + children[0].toString() + ")";
+    }
+    return "";
+  }
+
+  void sample(std::mt19937& rng, std::string& out) const {
+    switch (type) {
+      case ExprssionType::Value: {
+        out += value;
+        break;
+      }
+      case ExprssionType::Add: {
+        children[0].sample(rng, out);
+        children[1].sample(rng, out);
+        break;
+      }
+      case ExprssionType::Or: {
+        children[rng() % 2].sample(rng, out);
+        break;
+      }
+      case ExprssionType::Star: {
+        for (auto i = rng() % 4; i > 0; --i) children[0].sample(rng, out);
+        break;
+      }
+      case ExprssionType::Brackets: {
+        children[0].sample(rng, out);
+        break;
+      }
+    }
+  }
+};
+
+PatternNode generateAtom(std::mt19937& rng, size_t depth);
+
+// term of a concatenation, an atom optionally followed by one or two kleene closures. Closures of atoms matching the
+// empty string, like a** or (a*)*, are the epsilon loops the subset construction has to get right
+PatternNode generateFactor(std::mt19937& rng, size_t depth) {
+  auto node = generateAtom(rng, depth);
+  // a third of the atoms is closed, and a third of those closed twice
+  auto roll = rng() % 9;
+  if (roll < 3) node = {ExprssionType::Star, 0, {std::move(node)}};
+  if (roll == 0) node = {ExprssionType::Star, 0, {std::move(node)}};
+  return node;
+}
+
+PatternNode generateConcatenation(std::mt19937& rng, size_t depth) {
+  auto node = generateFactor(rng, depth);
+  for (auto i = rng() % 3; i > 0; --i) {
+    node = {ExprssionType::Add, 0, {std::move(node), generateFactor(rng, depth)}};
+  }
+  return node;
+}
+
+// the parser makes '|' take everything up to the closing bracket as its right side, so alternations nest to the right
+PatternNode generateAlternation(std::mt19937& rng, size_t depth) {
+  auto node = generateConcatenation(rng, depth);
+  if (rng() % 3 == 0) return {ExprssionType::Or, 0, {std::move(node), generateAlternation(rng, depth)}};
+  return node;
+}
+
+PatternNode generateAtom(std::mt19937& rng, size_t depth) {
+  if (depth > 0 && rng() % 3 == 0) {
+    return {ExprssionType::Brackets, 0, {generateAlternation(rng, depth - 1)}};
+  }
+  return {ExprssionType::Value, ALPHABET[rng() % ALPHABET.size()], {}};
+}
+
+/**
+ * Results of std::regex on the inputs of a pattern
+ */
+struct RegexRun {
+  double compile_ms{};
+  std::vector<TimedMatch> matches;  // results of the inputs std::regex finished, in order
+};
+
+/**
+ * Function that converts a pattern to the ECMAScript grammar of std::regex, where a closure can't follow a closure.
+ * Repeated closures are collapsed, since a** matches the same strings as a*
+ * @param pattern pattern in the grammar of this project
+ * @return pattern for std::regex
+ */
+std::string toEcmaScript(const std::string& pattern) {
+  std::string converted;
+  for (const auto& symbol : pattern) {
+    if (symbol == '*' && !converted.empty() && converted.back() == '*') continue;
+    converted += symbol;
+  }
+  return converted;
+}
+
+/**
+ * Function that reads a value written by the child process running std::regex
+ * @param fd read end of the pipe
+ * @param value value to fill
+ * @return false if the value didn't arrive within REGEX_TIMEOUT_MS, or the child ended before writing it
+ */
+template <typename T>
+bool readFromChild(int fd, T& value) {
+  pollfd poll_fd{fd, POLLIN, 0};
+  auto* bytes = reinterpret_cast<char*>(&value);
+  for (size_t done = 0; done < sizeof(T);) {
+    if (poll(&poll_fd, 1, REGEX_TIMEOUT_MS) <= 0) return false;
+    auto count = read(fd, bytes + done, sizeof(T) - done);
+    if (count <= 0) return false;
+    done += count;
+  }
+  return true;
+}
+
+/**
+ * Function that compiles a pattern with std::regex and matches the inputs with it in a child process. std::regex
+ * backtracks and on nested closures like (1*(0*-*)*)* doesn't finish in any reasonable time, running it in a child
+ * lets the test give up on such an input and kill it
+ * @param pattern pattern in the grammar of this project
+ * @param inputs strings to match
+ * @return results of the inputs finished within REGEX_TIMEOUT_MS each
+ */
+RegexRun runRegex(const std::string& pattern, const std::vector<std::string>& inputs) {
+  RegexRun run;
+  int fds[2];
+  if (pipe(fds) != 0) return run;
+  auto child = fork();
+  if (child == 0) {
+    close(fds[0]);
+    auto start = Clock::now();
+    std::regex regex(toEcmaScript(pattern));
+    auto compile_ms = millisecondsSince(start);
+    if (write(fds[1], &compile_ms, sizeof(compile_ms)) != sizeof(compile_ms)) _exit(1);
+    for (const auto& input : inputs) {
+      auto match = timeMatch([&input, &regex]() { return std::regex_match(input, regex); });
+      if (write(fds[1], &match, sizeof(match)) != sizeof(match)) _exit(1);
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+  if (child > 0 && readFromChild(fds[0], run.compile_ms)) {
+    TimedMatch match{};
+    while (run.matches.size() < inputs.size() && readFromChild(fds[0], match)) {
+      run.matches.push_back(match);
+    }
+  }
+  if (child > 0) {
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+  }
+  close(fds[0]);
+  return run;
+}
+
+struct Totals {
+  double dfa_compile_ms{};
+  double regex_compile_ms{};
+  double dfa_match_ms{};
+  double regex_match_ms{};
+  size_t bytes{};
+  size_t patterns{};
+  size_t inputs{};
+  size_t disagreements{};
+  size_t cliffs{};
+  size_t skipped{};
+};
+
+/**
+ * Function that compares the DFA with std::regex_match on given inputs
+ * @param pattern pattern in the grammar of this project
+ * @param inputs strings to match
+ * @param totals accumulated times and counters
+ * @param corpus if not nullptr, disagreements and performance cliffs are appended to it
+ * @return true if both engines agreed on all inputs std::regex finished
+ */
+bool compare(const std::string& pattern, const std::vector<std::string>& inputs, Totals& totals,
+             std::ofstream* corpus) {
+  auto start = Clock::now();
+  auto ret = DFA::generateDfaFromRE(pattern);
+  auto dfa_compile_ms = millisecondsSince(start);
+  if (ret.err) {
+    std::cout << RED << "ERROR, DFA could not be created for " << CYAN << pattern << RED
+              << " becasue: " << SMALLRED << (*ret.err).msg << RESET << "\n";
+    if (corpus) *corpus << pattern << "\t\tcompile error\n";
+    totals.disagreements++;
+    return false;
+  }
+  auto dfa = std::move(*ret.data);
+  auto regex_run = runRegex(pattern, inputs);
+
+  totals.patterns++;
+  totals.dfa_compile_ms += dfa_compile_ms;
+  totals.regex_compile_ms += regex_run.compile_ms;
+  // cliffs are stored without their timing, which depends on the machine, the replay times them again
+  if (dfa_compile_ms > COMPILE_CLIFF_MS) {
+    std::cout << YELLOW << "compile cliff for " << CYAN << pattern << YELLOW << ": " << dfa_compile_ms << " ms"
+              << RESET << "\n";
+    if (corpus) *corpus << pattern << "\t\tcliff\n";
+    totals.cliffs++;
+  }
+
+  bool agreed = true;
+  bool match_cliff = false;
+  for (size_t i = 0; i < regex_run.matches.size(); ++i) {
+    const auto& input = inputs[i];
+    auto dfa_match = timeMatch([&dfa, &input]() { return dfa.parseExpression(input); });
+    const auto& regex_match = regex_run.matches[i];
+
+    totals.inputs++;
+    totals.bytes += input.size();
+    totals.dfa_match_ms += dfa_match.ms;
+    totals.regex_match_ms += regex_match.ms;
+    if (dfa_match.result != regex_match.result) {
+      std::cout << RED << "disagreement for " << CYAN << pattern << RED << " on '" << input << "': DFA "
+                << dfa_match.result << ", std::regex " << regex_match.result << RESET << "\n";
+      if (corpus) *corpus << pattern << "\t" << input << "\tdisagreement\n";
+      totals.disagreements++;
+      agreed = false;
+    } else if (!match_cliff && dfa_match.ms > MATCH_CLIFF_MS && dfa_match.ms > MATCH_CLIFF_RATIO * regex_match.ms) {
+      // a single report per pattern is enough to reproduce the cliff
+      std::cout << YELLOW << "match cliff for " << CYAN << pattern << YELLOW << " on '" << input << "': "
+                << dfa_match.ms << " ms" << RESET << "\n";
+      if (corpus) *corpus << pattern << "\t" << input << "\tcliff\n";
+      totals.cliffs++;
+      match_cliff = true;
+    }
+  }
+  if (regex_run.matches.size() < inputs.size()) {
+    std::cout << YELLOW << "std::regex gave up on " << CYAN << pattern << YELLOW << " on '"
+              << inputs[regex_run.matches.size()] << "', " << inputs.size() - regex_run.matches.size()
+              << " inputs skipped" << RESET << "\n";
+    totals.skipped += inputs.size() - regex_run.matches.size();
+  }
+  return agreed;
+}
+
+/**
+ * Function that replays all entries of the regression corpus. Cliffs are timed again and reported when they don't
+ * reproduce anymore, but only disagreements fail the run
+ * @param totals accumulated times and counters
+ * @return number of entries that still disagree
+ */
+size_t replayCorpus(Totals& totals) {
+  std::ifstream file(CORPUS_FILE);
+  std::string line;
+  size_t failures = 0;
+  while (std::getline(file, line)) {
+    if (line.empty() || line.at(0) == '#') continue;
+    std::istringstream fields(line);
+    std::string pattern;
+    std::string input;
+    std::string note;
+    std::getline(fields, pattern, '\t');
+    std::getline(fields, input, '\t');
+    std::getline(fields, note, '\t');
+    auto cliffs = totals.cliffs;
+    if (!compare(pattern, {input}, totals, nullptr)) failures++;
+    if (note == "cliff" && totals.cliffs == cliffs) {
+      std::cout << GREEN << "cliff for " << CYAN << pattern << GREEN << " on '" << input << "' doesn't reproduce"
+                << RESET << "\n";
+    }
+  }
+  return failures;
+}
+
+void printTotals(const std::string& title, const Totals& totals) {
+  auto throughput = [&totals](double ms) { return ms > 0 ? totals.bytes / ms / 1000.0 : 0.0; };
+  std::cout << YELLOW << "--- " << title << " ---" << RESET << "\n";
+  std::cout << "patterns: " << totals.patterns << ", inputs: " << totals.inputs << ", bytes: " << totals.bytes
+            << "\n";
+  std::cout << "           | compile ms |   match ms |       MB/s\n" << std::fixed << std::setprecision(3);
+  std::cout << "DFA        | " << std::setw(10) << totals.dfa_compile_ms << " | " << std::setw(10) << totals.dfa_match_ms
+            << " | " << std::setw(10) << throughput(totals.dfa_match_ms) << "\n";
+  std::cout << "std::regex | " << std::setw(10) << totals.regex_compile_ms << " | " << std::setw(10)
+            << totals.regex_match_ms << " | " << std::setw(10) << throughput(totals.regex_match_ms) << "\n";
+  std::cout << std::defaultfloat;
+  std::cout << (totals.disagreements ? RED : GREEN) << "disagreements: " << totals.disagreements << RESET
+            << ", performance cliffs: " << totals.cliffs << ", inputs std::regex gave up on: " << totals.skipped
+            << "\n\n";
+}
+
+int main(int argc, char** argv) {
+  size_t iterations = argc > 1 ? std::stoul(argv[1]) : 500;
+  unsigned seed = argc > 2 ? std::stoul(argv[2]) : std::random_device()();
+  std::cout << "differential test against std::regex, " << iterations << " patterns, seed " << seed << "\n\n";
+
+  Totals corpus_totals;
+  auto corpus_failures = replayCorpus(corpus_totals);
+  printTotals("regression corpus", corpus_totals);
+
+  std::mt19937 rng(seed);
+  std::ofstream corpus(CORPUS_FILE, std::ios::app);
+  Totals totals;
+  for (size_t i = 0; i < iterations; ++i) {
+    auto node = generateAlternation(rng, 2);
+    std::vector<std::string> inputs;
+    for (size_t j = 0; j < 8; ++j) {
+      std::string input;
+      node.sample(rng, input);
+      inputs.push_back(std::move(input));
+    }
+    for (size_t j = 0; j < 8; ++j) {
+      std::string input;
+      for (auto k = rng() % 16; k > 0; --k) input += ALPHABET[rng() % ALPHABET.size()];
+      inputs.push_back(std::move(input));
+    }
+    compare(node.toString(), inputs, totals, &corpus);
+  }
+  printTotals("random patterns", totals);
+  return corpus_failures || totals.disagreements ? 1 : 0;
+}
@@ -36,7 +36,11 @@ struct ErrOr {
 
   ErrOr() = default;
   ErrOr(const Error& err) : err(err) {}
+  ErrOr(Error&& err) : err(std::move(err)) {}
   ErrOr(const T& data) : data(data) {}
   ErrOr(T&& data) : data(std::move(data)) {}
 };
+
+constexpr size_t npos = static_cast<size_t>(-1);  // index of a state or position that doesn't exist
+
 #define ERROR_WITH_FILE(msg) Error((msg) + std::string(" at ") + __FILE__ + ":" + std::to_string(__LINE__))
@@ -0,0 +1,209 @@
+#include "literals.h"
+
+#include <algorithm>
+#include <deque>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEDDY_SSSE3
+#endif
+
+/**
+ * Function that appends the literal an expression matches to a string
+ * @param expr parsed expression
+ * @param literal string the literal is appended to
+ * @return false if the expression matches anything else than a single string
+ */
+static bool appendLiteral(const SPExpression& expr, std::string& literal) {
+  switch (expr->getType()) {
+    case ExprssionType::Value: {
+      if (expr->getValue() != expr->getLastValue()) return false;
+      literal += expr->getValue();
+      return true;
+    }
+    case ExprssionType::Add: {
+      return appendLiteral(expr->getLeft(), literal) && appendLiteral(expr->getRight(), literal);
+    }
+    case ExprssionType::Brackets: {
+      return appendLiteral(expr->getLeft(), literal);
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool LiteralSearcher::extractLiterals(const SPExpression& expr, std::vector<std::string>& literals) {
+  if (!expr) return false;
+  switch (expr->getType()) {
+    case ExprssionType::Or: {
+      return extractLiterals(expr->getLeft(), literals) && extractLiterals(expr->getRight(), literals);
+    }
+    case ExprssionType::Brackets: {
+      return extractLiterals(expr->getLeft(), literals);
+    }
+    default: {
+      std::string literal;
+      if (!appendLiteral(expr, literal)) return false;
+      literals.push_back(std::move(literal));
+      return true;
+    }
+  }
+}
+
+LiteralSearcher::LiteralSearcher(std::vector<std::string> literals) : _literals(std::move(literals)) {
+  _min_length = _literals.empty() ? 0 : _literals.front().size();
+  for (const auto& literal : _literals) {
+    _min_length = std::min(_min_length, literal.size());
+  }
+  _teddy = _literals.size() <= TEDDY_MAX_LITERALS && _min_length > 0;
+  if (_teddy) {
+    buildTeddy();
+  } else {
+    buildAhoCorasick();
+  }
+}
+
+void LiteralSearcher::buildAhoCorasick() {
+  _goto.assign(256, npos);
+  _longest.assign(1, 0);
+  for (const auto& literal : _literals) {
+    size_t state = 0;
+    for (const auto& symbol : literal) {
+      auto& next = _goto[state * 256 + static_cast<unsigned char>(symbol)];
+      if (next == npos) {
+        next = _longest.size();
+        _longest.push_back(0);
+        _goto.resize(_goto.size() + 256, npos);
+      }
+      state = _goto[state * 256 + static_cast<unsigned char>(symbol)];
+    }
+    _longest[state] = literal.size();
+  }
+
+  // breadth first search, so the failure state of every state is complete before the state itself
+  std::vector<size_t> failure(_longest.size(), 0);
+  std::deque<size_t> queue{0};
+  while (!queue.empty()) {
+    auto state = queue.front();
+    queue.pop_front();
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      auto& next = _goto[state * 256 + symbol];
+      auto fallback = state == 0 ? 0 : _goto[failure[state] * 256 + symbol];
+      if (next == npos) {
+        next = fallback;
+        continue;
+      }
+      failure[next] = fallback;
+      if (!_longest[next]) _longest[next] = _longest[fallback];
+      queue.push_back(next);
+    }
+  }
+}
+
+void LiteralSearcher::buildTeddy() {
+  _fingerprint = std::min(_min_length, TEDDY_MAX_FINGERPRINT);
+  for (size_t i = 0; i < _literals.size(); ++i) {
+    auto bucket = i % TEDDY_BUCKETS;
+    _buckets[bucket].push_back(i);
+    for (size_t k = 0; k < _fingerprint; ++k) {
+      auto byte = static_cast<unsigned char>(_literals[i][k]);
+      _low_masks[k][byte & 0x0F] |= 1 << bucket;
+      _high_masks[k][byte >> 4] |= 1 << bucket;
+    }
+  }
+}
+
+std::optional<std::pair<size_t, size_t>> LiteralSearcher::findAhoCorasick(std::string_view text, size_t from) const {
+  size_t state = 0;
+  for (auto i = from; i < text.size(); ++i) {
+    state = _goto[state * 256 + static_cast<unsigned char>(text[i])];
+    if (_longest[state]) return std::make_pair(i + 1 - _longest[state], i + 1);
+  }
+  return std::nullopt;
+}
+
+void LiteralSearcher::verify(std::string_view text, size_t position, uint8_t buckets,
+                             std::optional<std::pair<size_t, size_t>>& match) const {
+  for (size_t bucket = 0; bucket < TEDDY_BUCKETS; ++bucket) {
+    if (!(buckets & (1 << bucket))) continue;
+    for (const auto& index : _buckets[bucket]) {
+      const auto& literal = _literals[index];
+      if (text.compare(position, literal.size(), literal) != 0) continue;
+      auto end = position + literal.size();
+      if (!match || end < match->second || (end == match->second && position < match->first)) {
+        match = std::make_pair(position, end);
+      }
+    }
+  }
+}
+
+#ifdef TEDDY_SSSE3
+/**
+ * Function that looks up the fingerprints of 16 positions at once, until the match ending first is known or there
+ * are less than 16 positions with a full fingerprint left
+ * @return position the scalar search has to continue from
+ */
+template <typename Verify>
+__attribute__((target("ssse3"))) static size_t findTeddySsse3(
+    std::string_view text, size_t position, size_t fingerprint, size_t min_length,
+    const std::array<std::array<uint8_t, 16>, 3>& low_masks, const std::array<std::array<uint8_t, 16>, 3>& high_masks,
+    const Verify& verify, const std::optional<std::pair<size_t, size_t>>& match) {
+  const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+  const auto nibble = _mm_set1_epi8(0x0F);
+  __m128i low[3];
+  __m128i high[3];
+  for (size_t k = 0; k < fingerprint; ++k) {
+    low[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low_masks[k].data()));
+    high[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high_masks[k].data()));
+  }
+  alignas(16) std::array<uint8_t, 16> buckets{};
+  for (; position + 16 + fingerprint - 1 <= text.size(); position += 16) {
+    if (match && position + min_length >= match->second) return position;
+    auto result = _mm_set1_epi8(static_cast<char>(0xFF));
+    for (size_t k = 0; k < fingerprint; ++k) {
+      auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + k));
+      auto low_nibbles = _mm_and_si128(chunk, nibble);
+      auto high_nibbles = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble);
+      result = _mm_and_si128(result, _mm_and_si128(_mm_shuffle_epi8(low[k], low_nibbles),
+                                                   _mm_shuffle_epi8(high[k], high_nibbles)));
+    }
+    auto candidates = ~_mm_movemask_epi8(_mm_cmpeq_epi8(result, _mm_setzero_si128())) & 0xFFFF;
+    if (!candidates) continue;
+    _mm_store_si128(reinterpret_cast<__m128i*>(buckets.data()), result);
+    for (; candidates; candidates &= candidates - 1) {
+      auto lane = __builtin_ctz(candidates);
+      verify(position + lane, buckets[lane]);
+    }
+  }
+  return position;
+}
+#endif
+
+std::optional<std::pair<size_t, size_t>> LiteralSearcher::findTeddy(std::string_view text, size_t from) const {
+  std::optional<std::pair<size_t, size_t>> match;
+  auto position = from;
+#ifdef TEDDY_SSSE3
+  if (__builtin_cpu_supports("ssse3")) {
+    position = findTeddySsse3(
+        text, position, _fingerprint, _min_length, _low_masks, _high_masks,
+        [this, &text, &match](size_t candidate, uint8_t buckets) { verify(text, candidate, buckets, match); }, match);
+  }
+#endif
+  for (; position + _min_length <= text.size(); ++position) {
+    // a literal starting here or later can't end before the match found already
+    if (match && position + _min_length >= match->second) break;
+    uint8_t buckets = 0xFF;
+    for (size_t k = 0; k < _fingerprint; ++k) {
+      auto byte = static_cast<unsigned char>(text[position + k]);
+      buckets &= _low_masks[k][byte & 0x0F] & _high_masks[k][byte >> 4];
+    }
+    if (buckets) verify(text, position, buckets, match);
+  }
+  return match;
+}
+
+std::optional<std::pair<size_t, size_t>> LiteralSearcher::find(std::string_view text, size_t from) const {
+  if (from > text.size()) return std::nullopt;
+  return _teddy ? findTeddy(text, from) : findAhoCorasick(text, from);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "reg_exp.h"
+
+/**
+ * Searcher for expressions that are only an alternation of literal strings, like 123|abc|bba. Small sets are
+ * searched with Teddy: SIMD shuffles look up the first bytes of 16 positions at once in nibble masks, and only
+ * positions whose fingerprint fits some literal are verified. Large sets use an Aho-Corasick automaton
+ */
+class LiteralSearcher {
+  static constexpr size_t TEDDY_MAX_LITERALS = 32;
+  static constexpr size_t TEDDY_BUCKETS = 8;
+  static constexpr size_t TEDDY_MAX_FINGERPRINT = 3;
+
+  std::vector<std::string> _literals;
+  size_t _min_length{};
+  bool _teddy{};
+
+  // Aho-Corasick
+  std::vector<size_t> _goto;     // next state for every state and byte, failure transitions are already included
+  std::vector<size_t> _longest;  // length of the longest literal ending in every state, 0 if none
+
+  // Teddy
+  size_t _fingerprint{};  // number of leading bytes of a literal compared by the masks
+  // for every fingerprint byte, buckets of the literals having given low and high nibble at that byte
+  std::array<std::array<uint8_t, 16>, TEDDY_MAX_FINGERPRINT> _low_masks{};
+  std::array<std::array<uint8_t, 16>, TEDDY_MAX_FINGERPRINT> _high_masks{};
+  std::array<std::vector<size_t>, TEDDY_BUCKETS> _buckets;  // indices of the literals in every bucket
+
+  void buildAhoCorasick();
+  void buildTeddy();
+
+  [[nodiscard]] std::optional<std::pair<size_t, size_t>> findAhoCorasick(std::string_view text, size_t from) const;
+  [[nodiscard]] std::optional<std::pair<size_t, size_t>> findTeddy(std::string_view text, size_t from) const;
+
+  /**
+   * Function that verifies the literals of buckets at a candidate position, and keeps the match ending first
+   * @param text text to search
+   * @param position candidate start
+   * @param buckets bits of the buckets whose fingerprint fits the candidate
+   * @param match match ending first so far, updated if a literal ends before it
+   */
+  void verify(std::string_view text, size_t position, uint8_t buckets,
+              std::optional<std::pair<size_t, size_t>>& match) const;
+
+ public:
+  explicit LiteralSearcher(std::vector<std::string> literals);
+
+  /**
+   * Function that checks if an expression is only an alternation of literals, and collects them
+   * @param expr parsed expression
+   * @param literals vector the literals are appended to
+   * @return true if the expression consists only of literals, '|' and brackets
+   */
+  static bool extractLiterals(const SPExpression& expr, std::vector<std::string>& literals);
+
+  /**
+   * Function that finds the literal that ends first in a text, and for that end the longest literal
+   * @param text text to search
+   * @param from position to start searching at
+   * @return start and end (exclusive) of the match, or nullopt if there is none
+   */
+  [[nodiscard]] std::optional<std::pair<size_t, size_t>> find(std::string_view text, size_t from = 0) const;
+
+  [[nodiscard]] bool usesTeddy() const { return _teddy; }
+};
@@ -1,6 +1,18 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <tuple>
 
 #include "dfa.h"
+#include "pattern_set.h"
+#include "scan.h"
+#include "search.h"
+#include "tagged_dfa.h"
+#ifdef COUNT_ALLOCATIONS
+#include "alloc_counter.h"
+#endif
 
 void testParsingV1() {
   std::cout << YELLOW << "--- Parsing test for RE " << CYAN << "(a|b)*abb" << YELLOW << " ---" << RESET << "\n";
@@ -8,7 +20,7 @@ void testParsingV1() {
   if (ret.err) {
     std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
   }
-  auto dfa = *ret.data;
+  auto dfa = std::move(*ret.data);
   auto str = "abb";
   std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
   str = "abababb";
@@ -29,7 +41,7 @@ void testParsingV2() {
   if (ret.err) {
     std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
   }
-  auto dfa = *ret.data;
+  auto dfa = std::move(*ret.data);
   auto str = "123";
   std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
   str = "abbb";
@@ -58,7 +70,7 @@ void testParsingV3() {
   if (ret.err) {
     std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
   }
-  auto dfa = *ret.data;
+  auto dfa = std::move(*ret.data);
   auto str = "05-12-1999";
   std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
   str = "05-11-123";
@@ -76,6 +88,343 @@ void testParsingV3() {
   str = "a1-22-33";
   std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
 }
+void testCaptures() {
+  std::string digit = "(1|2|3|4|5|6|7|8|9|0)";
+  std::string expression = "(" + digit + digit + ")-(" + digit + digit + ")-(" + digit + "*)";
+  std::cout << YELLOW << "--- Capture test for RE " << CYAN << expression << YELLOW << " ---" << RESET << "\n";
+  auto ret = TaggedDFA::generateTaggedDfaFromRE(expression);
+  if (ret.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  const auto& dfa = *ret.data;
+  std::vector<Submatch> groups;
+  for (const std::string str : {"05-12-1999", "01-02-", "1-22-33"}) {
+    if (!dfa.parseExpression(str, groups)) {
+      std::cout << str << " incorrect\n";
+      continue;
+    }
+    std::cout << str << " correct, fields:";
+    for (const auto& group : {1, 4, 7}) {
+      std::cout << " '" << str.substr(groups[group].start, groups[group].end - groups[group].start) << "'";
+    }
+    std::cout << "\n";
+  }
+
+  expression = "((a)|b)*(c*)";
+  std::cout << YELLOW << "--- Capture test for RE " << CYAN << expression << YELLOW << " ---" << RESET << "\n";
+  ret = TaggedDFA::generateTaggedDfaFromRE(expression);
+  if (ret.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  for (const std::string str : {"abacc", "b", ""}) {
+    if (!(*ret.data).parseExpression(str, groups)) {
+      std::cout << "'" << str << "' incorrect\n";
+      continue;
+    }
+    std::cout << "'" << str << "' correct, groups:";
+    for (size_t group = 1; group < groups.size(); ++group) {
+      if (groups[group].matched) {
+        std::cout << " [" << groups[group].start << ", " << groups[group].end << ")";
+      } else {
+        std::cout << " unset";
+      }
+    }
+    std::cout << "\n";
+  }
+}
+
+void testUtf8() {
+  std::cout << YELLOW << "--- Parsing test for RE " << CYAN << "zaż(ółć)*|[α-ω][^a-z€]*" << YELLOW << " ---" << RESET
+            << "\n";
+  auto ret = DFA::generateDfaFromRE("zaż(ółć)*|[α-ω][^a-z€]*");
+  if (ret.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  auto dfa = std::move(*ret.data);
+  for (const auto& str : {"zaż", "zażółćółć", "zażół", "za\xC5", "λ", "ω1ż𝄞Z", "λa", "λ€", "λ\xED\xA0\x80", "a"}) {
+    std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
+  }
+}
+
+void testPatternSet() {
+  std::cout << YELLOW << "--- Pattern set test ---" << RESET << "\n";
+  PatternSet set(2);
+  auto printMatches = [&set](const std::string& str) {
+    std::cout << str << " accepted by patterns:";
+    for (const auto& id : set.match(str)) std::cout << " " << id;
+    std::cout << "\n";
+  };
+  for (const auto& expression : {"(a|b)*abb", "abb", "123|abc", "a*b*"}) {
+    auto ret = set.add(expression);
+    if (ret.err) {
+      std::cout << RED << "ERROR, pattern could not be added" << RESET << "\n";
+      return;
+    }
+    std::cout << "added " << CYAN << expression << RESET << " as " << *ret.data << "\n";
+  }
+  printMatches("abb");
+  printMatches("abc");
+  std::cout << "removing 1 " << (set.remove(1) ? "succeeded" : "failed") << "\n";
+  std::cout << "removing 1 " << (set.remove(1) ? "succeeded" : "failed") << "\n";
+  printMatches("abb");
+  std::cout << "added " << CYAN << "ab*" << RESET << " as " << *set.add("ab*").data << "\n";
+  printMatches("abb");
+  std::cout << "removing 0 " << (set.remove(0) ? "succeeded" : "failed") << "\n";
+  printMatches("abb");
+  printMatches("123");
+#ifdef COUNT_ALLOCATIONS
+  // the NFA of a pattern with '*' has a cycle, removing the pattern has to free it anyway
+  auto cycle = [&set]() { set.remove(*set.add("(a|b)*abb(c|d)*").data); };
+  cycle();
+  auto live = liveAllocations();
+  for (int i = 0; i < 100; ++i) cycle();
+  if (liveAllocations() > live) {
+    std::cout << RED << "ERROR, " << liveAllocations() - live << " allocations still live after adding and removing "
+              << "(a|b)*abb(c|d)* 100 times" << RESET << "\n";
+  } else {
+    std::cout << GREEN << "memory of (a|b)*abb(c|d)* released after adding and removing it 100 times" << RESET << "\n";
+  }
+#endif
+}
+
+void testSearch() {
+  std::cout << YELLOW << "--- Reverse DFA test for RE " << CYAN << "(a|b)*abb" << YELLOW << " ---" << RESET << "\n";
+  auto reversed = DFA::generateReverseDfaFromRE("(a|b)*abb");
+  if (reversed.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  for (const auto& str : {"bba", "bbaba", "abb"}) {
+    std::cout << str << ((*reversed.data).parseExpression(str) ? " correct\n" : " incorrect\n");
+  }
+
+  for (const auto& [expression, text] : {std::pair{"(a|b)*abb", "xxbabababbyabb"}, std::pair{"abcd|bc", "xabcd"},
+                                         std::pair{"b(a|b)*a", "cbbaab"}, std::pair{"a*", "bb"},
+                                         std::pair{"123|abc|(bb(a))", "xbbabc123abcbbb"}, std::pair{"aab|ab|b", "aaab"}}) {
+    std::cout << YELLOW << "--- Search test for RE " << CYAN << expression << YELLOW << " ---" << RESET << "\n";
+    auto ret = DfaSearcher::generateSearcherFromRE(expression);
+    if (ret.err) {
+      std::cout << RED << "ERROR, searcher could not be created" << RESET << "\n";
+      return;
+    }
+    const auto& literals = (*ret.data).getLiteralSearcher();
+    if (literals) std::cout << (literals->usesTeddy() ? "Teddy, " : "Aho-Corasick, ");
+    std::cout << "suffix '" << (*ret.data).getSuffix() << "', in " << text << ":";
+    for (size_t from = 0; from <= std::string(text).size();) {
+      auto match = (*ret.data).find(text, from);
+      if (!match) break;
+      std::cout << " [" << match->first << ", " << match->second << ")";
+      from = std::max(match->second, match->first + 1);
+    }
+    std::cout << "\n";
+  }
+
+  std::string expression = "k0";
+  std::string text;
+  for (int i = 1; i < 40; ++i) {
+    expression += "|k" + std::to_string(i);
+    text += "k" + std::to_string(i * 7 % 40) + "x";
+  }
+  std::cout << YELLOW << "--- Search test for RE " << CYAN << "k0|k1|...|k39" << YELLOW << " ---" << RESET << "\n";
+  auto ret = DfaSearcher::generateSearcherFromRE(expression);
+  if (ret.err) {
+    std::cout << RED << "ERROR, searcher could not be created" << RESET << "\n";
+    return;
+  }
+  std::cout << ((*ret.data).getLiteralSearcher()->usesTeddy() ? "Teddy" : "Aho-Corasick") << ", matches:";
+  for (size_t from = 0;;) {
+    auto match = (*ret.data).find(text, from);
+    if (!match) break;
+    std::cout << " " << text.substr(match->first, match->second - match->first);
+    from = match->second;
+  }
+  std::cout << "\n";
+}
+
+void testProfile() {
+  std::cout << YELLOW << "--- Profile test for RE " << CYAN << "(a|b)*abb|c(12)*3" << YELLOW << " ---" << RESET << "\n";
+  auto ret = DFA::generateDfaFromRE("(a|b)*abb|c(12)*3");
+  if (ret.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  auto dfa = std::move(*ret.data);
+  std::vector<std::string> corpus = {"c121212123", "c1212121212123", "abb", "c3", "c12x"};
+  auto print_profile = [&dfa, &corpus]() {
+    auto profile = dfa.profile(corpus);
+    std::cout << "start " << dfa.getStartState() << ", visits:";
+    for (const auto& visits : profile.visits) {
+      std::cout << " " << visits;
+    }
+    auto hottest = std::max_element(profile.transitions.begin(), profile.transitions.end()) -
+                   profile.transitions.begin();
+    std::cout << ", hottest transition " << hottest / 256 << " -" << static_cast<char>(hottest % 256) << "-> "
+              << dfa.nextState(hottest / 256, static_cast<char>(hottest % 256)) << " taken "
+              << profile.transitions[hottest] << " times\n";
+  };
+  print_profile();
+  auto profile = dfa.profile(corpus);
+  if (dfa.reorderStates(profile)) {
+    std::cout << RED << "ERROR, states could not be reordered" << RESET << "\n";
+    return;
+  }
+  print_profile();
+  auto other = DFA::generateDfaFromRE("c(12)*3");
+  auto err = (*other.data).reorderStates(profile);
+  std::cout << "reordering with a profile of another DFA " << (err ? "rejected: " + err->msg : "accepted") << "\n";
+  err = dfa.reorderStates(profile);
+  std::cout << "reordering again with the same profile " << (err ? "rejected: " + err->msg : "accepted") << "\n";
+  for (const auto& str : {"c12123", "c1213", "babb", "ab"}) {
+    std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
+  }
+}
+
+void testProduct() {
+  std::cout << YELLOW << "--- Product test for " << CYAN << "a and b but not c" << YELLOW << " ---" << RESET << "\n";
+  auto with_a = DFA::generateDfaFromRE("(a|b|c)*a(a|b|c)*");
+  auto with_b = DFA::generateDfaFromRE("(a|b|c)*b(a|b|c)*");
+  auto with_c = DFA::generateDfaFromRE("(a|b|c)*c(a|b|c)*");
+  if (with_a.err || with_b.err || with_c.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  auto both = DFA::generateProductDfa(*with_a.data, *with_b.data, ProductOperation::Intersection);
+  auto filter = DFA::generateProductDfa(both, *with_c.data, ProductOperation::Difference);
+  filter.print();
+  for (const auto& str : {"ab", "bba", "abc", "aa", ""}) {
+    std::cout << str << (filter.parseExpression(str) ? " correct\n" : " incorrect\n");
+  }
+
+  std::cout << YELLOW << "--- Product test for " << CYAN << "not (ab or c*)" << YELLOW << " ---" << RESET << "\n";
+  auto ab = DFA::generateDfaFromRE("ab");
+  auto cs = DFA::generateDfaFromRE("c*");
+  if (ab.err || cs.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  auto complement =
+      DFA::generateComplementDfa(DFA::generateProductDfa(*ab.data, *cs.data, ProductOperation::Union));
+  complement.print();
+  for (const auto& str : {"ab", "ccc", "", "abc", "b"}) {
+    std::cout << str << (complement.parseExpression(str) ? " correct\n" : " incorrect\n");
+  }
+}
+
+void testLiteralDfa() {
+  std::cout << YELLOW << "--- Literal DFA test for RE " << CYAN << "123|abc|bba|ab" << YELLOW << " ---" << RESET << "\n";
+  auto ret = DFA::generateDfaFromRE("123|abc|bba|ab");
+  if (ret.err) {
+    std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+    return;
+  }
+  const auto& dfa = *ret.data;
+  std::cout << (dfa.isLiteralSet() ? "generated from the literals, " : "generated from the NFA, ")
+            << dfa.getTrapState() << " states\n";
+  // the table of the trie is what products and complements run on, it has to agree with the set of literals
+  auto table = DFA::generateComplementDfa(DFA::generateComplementDfa(dfa));
+  for (const auto& str : {"123", "abc", "bba", "ab", "a", "abcd", "12", ""}) {
+    std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
+    if (dfa.parseExpression(str) != table.parseExpression(str)) {
+      std::cout << RED << "ERROR, the table of the trie doesn't agree on " << str << RESET << "\n";
+    }
+  }
+}
+
+void testStateWidth() {
+  for (const auto& expression :
+       {"(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)-(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)",
+        "(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)", "[a-z]*x[a-z][a-z]",
+        "[ab]*a[ab][ab][ab][ab][ab][ab][ab][ab][ab][ab][ab][ab][ab][ab][ab]"}) {
+    std::cout << YELLOW << "--- State width test for RE " << CYAN << expression << YELLOW << " ---" << RESET << "\n";
+    auto ret = DFA::generateDfaFromRE(expression);
+    if (ret.err) {
+      std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+      return;
+    }
+    const auto& dfa = *ret.data;
+    std::visit(
+        [](const auto& matcher) {
+          std::cout << matcher.getTableSize() << " bytes, " << matcher.getClassCount() << " byte classes, "
+                    << matcher.getPairTableSize() << " bytes for pairs of classes\n";
+        },
+        dfa.getMatcher());
+    std::cout << 8 * (1 << dfa.getMatcher().index()) << " bit state ids\n";
+    for (const auto& str : {"12-34", "1-234", "abbbbbbb", "aaaaaaaaa", "bbbbbbbb", "abcxyz", "abxyzz",
+                            "babbbbbbbbbbbbbbb", "aabbbbbbbbbbbbbbb"}) {
+      std::cout << str << (dfa.parseExpression(str) ? " correct\n" : " incorrect\n");
+    }
+  }
+}
+
+#ifdef COUNT_ALLOCATIONS
+void testAllocations() {
+  // budgets leave about a quarter of headroom over the counts measured when they were set, a compile going over them
+  // means copies crept back into the pipeline
+  struct Budget {
+    const char* expression;
+    size_t nfa;
+    size_t dfa;
+  };
+  for (const auto& [expression, nfa_budget, dfa_budget] :
+       {Budget{"(a|b)*abb", 40, 340}, Budget{"(aa|b*a)*|(123|bc*d)", 85, 570}, Budget{"[a-z]*x[a-z][a-z]", 45, 3300}}) {
+    std::cout << YELLOW << "--- Allocation test for RE " << CYAN << expression << YELLOW << " ---" << RESET << "\n";
+    auto before = allocationCount();
+    auto nfa = NfaStructure::generateNfaFromRE(expression);
+    auto after_nfa = allocationCount();
+    auto dfa = DFA::generateDfaFromRE(expression);
+    auto after_dfa = allocationCount();
+    if (nfa.err || dfa.err) {
+      std::cout << RED << "ERROR, DFA could not be created" << RESET << "\n";
+      return;
+    }
+    for (const auto& [stage, count, budget] : {std::tuple{"NFA", after_nfa - before, nfa_budget},
+                                               std::tuple{"whole DFA", after_dfa - after_nfa, dfa_budget}}) {
+      if (count > budget) {
+        std::cout << RED << "ERROR, " << count << " allocations for the " << stage << " exceed the budget of "
+                  << budget << RESET << "\n";
+      } else {
+        std::cout << GREEN << count << " allocations for the " << stage << ", within the budget of " << budget
+                  << RESET << "\n";
+      }
+    }
+  }
+}
+#endif
+
+void testScan() {
+  std::cout << YELLOW << "--- Scan test for RE " << CYAN << "abb*c|x1" << YELLOW << " ---" << RESET << "\n";
+  auto directory = std::filesystem::temp_directory_path();
+  std::vector<std::string> files = {directory / "scan_test_1.txt", directory / "scan_test_2.txt",
+                                    directory / "scan_test_missing.txt", directory / "scan_test_3.txt"};
+  std::ofstream(files[0]) << "abbc\nac\n\nzzx1\nabc";
+  std::ofstream(files[1]) << "nothing here\n";
+  std::ofstream(files[3]) << "x\n1\nxx1\n";
+  for (const auto& count_only : {false, true}) {
+    auto ret = FileScanner::generateScannerFromRE("abb*c|x1", count_only, 2);
+    if (ret.err) {
+      std::cout << RED << "ERROR, scanner could not be created" << RESET << "\n";
+      return;
+    }
+    std::ostringstream out;
+    std::ostringstream errors;
+    auto totals = (*ret.data).scanFiles(files, out, errors);
+    // the directory differs between systems, so only the file names are printed
+    for (auto printed : {out.str(), "errors:\n" + errors.str()}) {
+      for (size_t position; (position = printed.find(directory.string() + "/")) != std::string::npos;) {
+        printed.erase(position, directory.string().size() + 1);
+      }
+      std::cout << printed;
+    }
+    std::cout << "total " << totals.matches << ", failed " << totals.failed << "\n";
+  }
+  for (const auto& file : files) {
+    std::filesystem::remove(file);
+  }
+}
+
 void generatingTest(const std::string& expression) {
   std::cout << YELLOW << "--- Generating DFA for RE " << CYAN << "" << expression << YELLOW << " ---" << RESET << "\n";
   auto ret = DFA::generateDfaFromRE(expression);
@@ -96,7 +445,7 @@ void creationTest(const std::string& expression) {
               << "\n";
     return;
   }
-  auto dfa = *ret.data;
+  auto dfa = std::move(*ret.data);
   dfa.print();
 }
 
@@ -104,6 +453,18 @@ void testAll() {
   testParsingV1();
   testParsingV2();
   testParsingV3();
+  testCaptures();
+  testUtf8();
+  testPatternSet();
+  testSearch();
+  testProfile();
+  testProduct();
+  testLiteralDfa();
+  testStateWidth();
+#ifdef COUNT_ALLOCATIONS
+  testAllocations();
+#endif
+  testScan();
   generatingTest("(aa|b*a)*|(123|bc*d)");
   generatingTest("(((a|b)*)*)*|1*2(1*|2*)*");
   generatingTest("(((a|b)*)*)*");
@@ -123,6 +484,10 @@ void testAll() {
   generatingTest("ab(123|)");
   generatingTest("ab|(123|456)*||d");
   generatingTest("ab*|*");
+  generatingTest("[a-");
+  generatingTest("[z-a]");
+  generatingTest("a[]");
+  generatingTest("a\xC5");
 
   creationTest("(a|bc)*|12*3");
   creationTest("((123)*4*|aBc)*");
@@ -131,7 +496,11 @@ void testAll() {
 void printHelp() {
   std::cout << "\t-h -- prints help\n\t-test -- runs all tests\n\t-run <expression> <string> -- generates a DFA from "
                "the first argument, if possible, and checks if the second argument can be accepted by the dfa. "
-               "Expression and string parameters must be passed in apostrophe\n";
+               "Expression and string parameters must be passed in apostrophe\n\t-capture <expression> <string> -- "
+               "generates a tagged DFA from the first argument and prints the capture groups of the second argument\n\t-scan "
+               "[-c] <expression> <file>... -- prints the lines of the files that contain a match of the expression, "
+               "or with -c only the number of those lines for every file. Files that can't be read are reported to "
+               "stderr and make it exit with 2\n";
 }
 int main(int argc, char** argv) {
   if (argc == 1) {
@@ -154,12 +523,62 @@ int main(int argc, char** argv) {
                 << "\n";
       return 0;
     }
-    auto dfa = *ret.data;
+    auto dfa = std::move(*ret.data);
     dfa.print();
     std::string str(argv[3]);
     std::cout << "string '" << str
               << (dfa.parseExpression(str) ? std::string("' is") + GREEN + " correct" + RESET + "\n"
                                            : std::string("' is ") + RED + "incorrect" + RESET + "\n");
+  } else if (flag == "-capture") {
+    if (argc != 4) {
+      std::cout << " Incorrect number of parameters!\n";
+      return 0;
+    }
+    std::string expression = argv[2];
+    std::cout << YELLOW << "--- Generating tagged DFA for RE " << CYAN << "" << expression << YELLOW << " ---" << RESET
+              << "\n";
+    auto ret = TaggedDFA::generateTaggedDfaFromRE(expression, true);
+    if (ret.err) {
+      std::cout << RED << "ERROR, DFA could not be created becasue: " << SMALLRED << (*ret.err).msg << "" << RESET
+                << "\n";
+      return 0;
+    }
+    auto dfa = std::move(*ret.data);
+    dfa.print();
+    std::string str(argv[3]);
+    std::vector<Submatch> groups;
+    if (!dfa.parseExpression(str, groups)) {
+      std::cout << "string '" << str << "' is " << RED << "incorrect" << RESET << "\n";
+      return 1;
+    }
+    std::cout << "string '" << str << "' is" << GREEN << " correct" << RESET << "\n";
+    for (size_t group = 0; group < groups.size(); ++group) {
+      std::cout << "group " << group << ": ";
+      if (groups[group].matched) {
+        std::cout << "'" << str.substr(groups[group].start, groups[group].end - groups[group].start) << "' at ["
+                  << groups[group].start << ", " << groups[group].end << ")\n";
+      } else {
+        std::cout << "unset\n";
+      }
+    }
+  } else if (flag == "-scan") {
+    auto count_only = argc > 2 && std::string(argv[2]) == "-c";
+    auto first = count_only ? 3 : 2;
+    if (argc < first + 2) {
+      std::cout << " Incorrect number of parameters!\n";
+      return 0;
+    }
+    auto ret = FileScanner::generateScannerFromRE(argv[first], count_only);
+    if (ret.err) {
+      std::cout << RED << "ERROR, DFA could not be created becasue: " << SMALLRED << (*ret.err).msg << "" << RESET
+                << "\n";
+      return 0;
+    }
+    std::vector<std::string> files(argv + first + 1, argv + argc);
+    // like grep, 2 if a file could not be read, otherwise 0 if any line matched
+    auto totals = (*ret.data).scanFiles(files, std::cout, std::cerr);
+    if (totals.failed) return 2;
+    return totals.matches ? 0 : 1;
   } else if (flag == "-test") {
     if (argc != 2) {
       std::cout << " Incorrect number of parameters!\n";
@@ -1,5 +1,9 @@
 #include "nfa.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 void NfaStructure::increaseIds(const SPNfaNode& root, const size_t& num) {
   if (!root || root->getWasSet()) return;
   root->getId() += num;
@@ -23,10 +27,10 @@ void NfaStructure::setWasIncreased(const SPNfaNode& root) {
   }
 }
 
-ErrOr<NfaStructure> NfaStructure::generateNfaFromExpression(const SPExpression& expr) {
+ErrOr<NfaStructure> NfaStructure::generateNfaFromExpression(const SPExpression& expr, bool tagged) {
   if (expr->getType() == ExprssionType::Value) {
     NfaStructure nfa;
-    auto temp = std::make_shared<NfaNode>(std::make_shared<NfaNode>(), expr->getValue());
+    auto temp = std::make_shared<NfaNode>(std::make_shared<NfaNode>(), expr->getValue(), expr->getLastValue());
     temp->setId(1);
     temp->getLeft()->setId(2);
     nfa.getSize() = 2;
@@ -35,14 +39,14 @@ ErrOr<NfaStructure> NfaStructure::generateNfaFromExpression(const SPExpression&
     return std::move(nfa);
   }
   if (!expr->getLeft()) return ERROR_WITH_FILE("Pointer to node expected to exist, but is nullptr");
-  auto ret = generateNfaFromExpression(expr->getLeft());
+  auto ret = generateNfaFromExpression(expr->getLeft(), tagged);
   if (ret.err) return *ret.err;
-  auto nfa = *ret.data;
+  auto nfa = std::move(*ret.data);
   switch (expr->getType()) {
     case ExprssionType::Add: {
-      ret = generateNfaFromExpression(expr->getRight());
+      ret = generateNfaFromExpression(expr->getRight(), tagged);
       if (ret.err) return *ret.err;
-      auto rhs = *ret.data;
+      auto rhs = std::move(*ret.data);
       rhs.increaseAllIds(nfa.getSize() - 1);
       nfa.getSize() += rhs.getSize() - 1;
       nfa.getFinal()->setNode(*rhs.getStart().get());
@@ -50,6 +54,22 @@ ErrOr<NfaStructure> NfaStructure::generateNfaFromExpression(const SPExpression&
       return std::move(nfa);
     }
     case ExprssionType::Brackets: {
+      if (!tagged || !expr->getGroup()) return std::move(nfa);
+      auto final = std::make_shared<NfaNode>();
+      auto start = std::make_shared<NfaNode>(nfa.getStart());
+      start->setTag(2 * expr->getGroup() - 1);
+
+      nfa.increaseAllIds(1);
+      start->setId(1);
+      final->setId(nfa.getSize() += 2);
+
+      nfa.getFinal()->setEpsilon(true);
+      nfa.getFinal()->setLeft(final);
+      nfa.getFinal()->setTag(2 * expr->getGroup());
+
+      nfa.setStart(start);
+      nfa.setFinal(final);
+
       return std::move(nfa);
     }
     case ExprssionType::Star: {
@@ -70,9 +90,9 @@ ErrOr<NfaStructure> NfaStructure::generateNfaFromExpression(const SPExpression&
       return std::move(nfa);
     }
     case ::ExprssionType::Or: {
-      ret = generateNfaFromExpression(expr->getRight());
+      ret = generateNfaFromExpression(expr->getRight(), tagged);
       if (ret.err) return *ret.err;
-      auto rhs = *ret.data;
+      auto rhs = std::move(*ret.data);
 
       auto start = std::make_shared<NfaNode>(nfa.getStart(), rhs.getStart());
       start->setId(1);
@@ -102,7 +122,7 @@ ErrOr<NfaStructure> NfaStructure::generateNfaFromExpression(const SPExpression&
   }
 }
 
-ErrOr<NfaStructure> NfaStructure::generateNfaFromRE(const std::string& expression, bool print) {
+ErrOr<NfaStructure> NfaStructure::generateNfaFromRE(const std::string& expression, bool print, bool tagged) {
   RegExpParser parser;
   auto ret = parser.parseExpression(expression);
   if (ret.err) {
@@ -113,7 +133,10 @@ ErrOr<NfaStructure> NfaStructure::generateNfaFromRE(const std::string& expressio
     ret.data.value().second->printTree();
     std::cout << "\n";
   }
-  return generateNfaFromExpression(ret.data.value().second);
+  auto nfa = generateNfaFromExpression(ret.data.value().second, tagged);
+  if (nfa.err) return *nfa.err;
+  if (tagged) nfa.data->_num_of_groups = parser.getGroupCount();
+  return nfa;
 }
 
 void NfaStructure::print(const SPNfaNode& root) {
@@ -125,10 +148,18 @@ void NfaStructure::print(const SPNfaNode& root) {
     if (root->getRight()) {
       std::cout << " and " << root->getRight()->getId();
     }
+    if (root->getTag()) {
+      std::cout << (root->getTag() % 2 ? " opening" : " closing") << " group " << (root->getTag() + 1) / 2;
+    }
     std::cout << std::endl;
   } else {
-    std::cout << "transition on character '" << root->getSymbol() << "' to node " << root->getLeft()->getId()
-              << std::endl;
+    if (root->getSymbol() == root->getLastSymbol()) {
+      std::cout << "transition on character '" << printableByte(root->getSymbol()) << "'";
+    } else {
+      std::cout << "transition on characters '" << printableByte(root->getSymbol()) << "'-'"
+                << printableByte(root->getLastSymbol()) << "'";
+    }
+    std::cout << " to node " << root->getLeft()->getId() << std::endl;
   }
   print(root->getLeft());
   if (root->getRight()) {
@@ -152,5 +183,121 @@ void NfaNode::setNode(const NfaNode& t) {
     _right = t._right;
     _eps = t._eps;
     _symbol = t._symbol;
+    _last_symbol = t._last_symbol;
+    _tag = t._tag;
+  }
+}
+
+SPNfaNode joinWithEpsilon(const std::vector<SPNfaNode>& nodes, size_t first, size_t last) {
+  if (last - first == 1) return nodes[first];
+  auto middle = first + (last - first) / 2;
+  return std::make_shared<NfaNode>(joinWithEpsilon(nodes, first, middle), joinWithEpsilon(nodes, middle, last));
+}
+
+/**
+ * Function that sets consecutive ids to all nodes reachable from root, in the order of the depth first search
+ * @param root starting node
+ * @param visited nodes that already have their id set
+ * @param id last id that was set
+ */
+static void setIds(const SPNfaNode& root, std::set<NfaNode*>& visited, size_t& id) {
+  std::vector<SPNfaNode> stack{root};
+  while (!stack.empty()) {
+    auto node = std::move(stack.back());
+    stack.pop_back();
+    if (!node || !visited.insert(node.get()).second) continue;
+    node->setId(++id);
+    stack.push_back(node->getRight());
+    stack.push_back(node->getLeft());
+  }
+}
+
+NfaStructure NfaStructure::reverse() const {
+  NfaStructure nfa;
+  if (!_start) return nfa;
+
+  std::map<NfaNode*, SPNfaNode> reversed;
+  std::vector<SPNfaNode> stack{_start};
+  while (!stack.empty()) {
+    auto node = std::move(stack.back());
+    stack.pop_back();
+    if (!node || reversed.contains(node.get())) continue;
+    reversed[node.get()] = std::make_shared<NfaNode>();
+    stack.push_back(node->getLeft());
+    stack.push_back(node->getRight());
+  }
+
+  // every flipped transition is either a new node moving on the original symbols, or the target itself for eps
+  std::map<NfaNode*, std::vector<SPNfaNode>> transitions;
+  std::set<NfaNode*> symbol_nodes;
+  for (const auto& [node, target] : reversed) {
+    if (!node->getLeft()) continue;
+    if (node->isEpsilon()) {
+      transitions[node->getLeft().get()].push_back(target);
+      if (node->getRight()) transitions[node->getRight().get()].push_back(target);
+    } else {
+      auto symbol_node = std::make_shared<NfaNode>(target, node->getSymbol(), node->getLastSymbol());
+      symbol_nodes.insert(symbol_node.get());
+      transitions[node->getLeft().get()].push_back(std::move(symbol_node));
+    }
+  }
+  // the old starting node may have transitions into it, so the new final node is a separate one
+  nfa._final = std::make_shared<NfaNode>();
+  transitions[_start.get()].push_back(nfa._final);
+
+  for (auto& [node, targets] : transitions) {
+    const auto& source = reversed[node];
+    // a single transition on symbols can be stored directly in the node, otherwise epsilon transitions are needed
+    if (targets.size() == 1 && symbol_nodes.contains(targets.front().get())) {
+      source->setNode(*targets.front());
+    } else if (targets.size() == 1) {
+      source->setEpsilon(true);
+      source->setLeft(targets.front());
+    } else {
+      auto middle = targets.size() / 2;
+      source->setEpsilon(true);
+      source->setLeft(joinWithEpsilon(targets, 0, middle));
+      source->setRight(joinWithEpsilon(targets, middle, targets.size()));
+    }
+  }
+  nfa._start = reversed[_final.get()];
+
+  std::set<NfaNode*> visited;
+  setIds(nfa._start, visited, nfa._num_of_nodes);
+  return nfa;
+}
+
+NfaStructure NfaStructure::unanchored() const {
+  NfaStructure nfa = *this;
+  if (!_start) return nfa;
+  auto start = std::make_shared<NfaNode>();
+  auto any = std::make_shared<NfaNode>(start, static_cast<char>(0x00), static_cast<char>(0xFF));
+  start->setEpsilon(true);
+  start->setLeft(any);
+  start->setRight(_start);
+  start->setId(++nfa._num_of_nodes);
+  any->setId(++nfa._num_of_nodes);
+  nfa._start = start;
+  return nfa;
+}
+
+void NfaStructure::releaseNodes() {
+  std::set<NfaNode*> visited;
+  std::vector<SPNfaNode> nodes;
+  std::vector<SPNfaNode> stack{_start};
+  while (!stack.empty()) {
+    auto node = std::move(stack.back());
+    stack.pop_back();
+    if (!node || !visited.insert(node.get()).second) continue;
+    stack.push_back(node->getLeft());
+    stack.push_back(node->getRight());
+    nodes.push_back(std::move(node));
+  }
+  for (const auto& node : nodes) {
+    node->setLeft(nullptr);
+    node->setRight(nullptr);
   }
+  _start = nullptr;
+  _final = nullptr;
+  _num_of_nodes = 0;
 }
@@ -7,12 +7,17 @@ class NfaNode {
   std::shared_ptr<NfaNode> _right;  // pointer to the second transition (only possible in the case of eps transition)
   bool _eps;                        // true if the node has epsilon transition(s)
   char _symbol{};                   // symbol of the transition, if transition is not eps
+  char _last_symbol{};              // last byte of the range of symbols of the transition, equal to _symbol usually
   size_t _id{};                     // id of a node, node with id = 1 is the starting node
+  size_t _tag{};  // tag recorded when the epsilon transition is taken, 2g - 1 opens and 2g closes group g, 0 if none
   bool _was_set{true};  // this boolean is used in setting node ids and printing, to ensure that a single node isn't
                         // affected more than once
 
  public:
-  NfaNode(std::shared_ptr<NfaNode> left, const char& symbol) : _left(std::move(left)), _symbol(symbol), _eps(false) {}
+  NfaNode(std::shared_ptr<NfaNode> left, const char& symbol)
+      : _left(std::move(left)), _symbol(symbol), _last_symbol(symbol), _eps(false) {}
+  NfaNode(std::shared_ptr<NfaNode> left, const char& symbol, const char& last_symbol)
+      : _left(std::move(left)), _symbol(symbol), _last_symbol(last_symbol), _eps(false) {}
   explicit NfaNode(std::shared_ptr<NfaNode> left) : _left(std::move(left)), _eps(true) {}
   NfaNode(std::shared_ptr<NfaNode> left, std::shared_ptr<NfaNode> right)
       : _left(std::move(left)), _right(std::move(right)), _eps(true) {}
@@ -22,6 +27,17 @@ class NfaNode {
   const std::shared_ptr<NfaNode>& getRight() { return _right; }
   [[nodiscard]] bool isEpsilon() const { return _eps; }
   [[nodiscard]] char getSymbol() const { return _symbol; }
+  [[nodiscard]] char getLastSymbol() const { return _last_symbol; }
+  /**
+   * Function that checks if the node has a transition on given byte
+   * @param symbol byte of the input
+   * @return true if the transition is not eps and the byte is within its range of symbols
+   */
+  [[nodiscard]] bool hasTransitionOn(char symbol) const {
+    return !_eps && _left && static_cast<unsigned char>(symbol) >= static_cast<unsigned char>(_symbol) &&
+           static_cast<unsigned char>(symbol) <= static_cast<unsigned char>(_last_symbol);
+  }
+  [[nodiscard]] size_t getTag() const { return _tag; }
   size_t& getId() { return _id; }
   bool& getWasSet() { return _was_set; }
 
@@ -29,16 +45,27 @@ class NfaNode {
   void setRight(const std::shared_ptr<NfaNode>& node) { _right = node; }
   void setEpsilon(bool eps) { _eps = eps; }
   void setId(const size_t& id) { _id = id; }
+  void setTag(size_t tag) { _tag = tag; }
 
   void setNode(const NfaNode& t);
 };
 
 typedef std::shared_ptr<NfaNode> SPNfaNode;
 
+/**
+ * Function that joins nodes with a balanced tree of epsilon transitions
+ * @param nodes nodes to join
+ * @param first index of the first node to join
+ * @param last index past the last node to join
+ * @return root of the tree
+ */
+SPNfaNode joinWithEpsilon(const std::vector<SPNfaNode>& nodes, size_t first, size_t last);
+
 class NfaStructure {
   SPNfaNode _start;
   SPNfaNode _final;
   size_t _num_of_nodes;
+  size_t _num_of_groups{0};  // number of capture groups, set only if the NFA was generated with tags
 
   NfaStructure() : _num_of_nodes(0) {}
 
@@ -47,7 +74,6 @@ class NfaStructure {
   void setFinal(const SPNfaNode& node) { _final = node; }
   size_t& getSize() { return _num_of_nodes; }
   void increaseAllIds(const size_t& num);
-  static ErrOr<NfaStructure> generateNfaFromExpression(const SPExpression& expr);
   void increaseIds(const SPNfaNode& root, const size_t& num);
   void setWasIncreased(const SPNfaNode& root);
 
@@ -61,11 +87,42 @@ class NfaStructure {
 
   [[nodiscard]] const SPNfaNode& getStart() const { return _start; }
   [[nodiscard]] const SPNfaNode& getFinal() const { return _final; }
+  [[nodiscard]] size_t getGroupCount() const { return _num_of_groups; }
 
   /**
    * Function that recursively transforms a tree
    * @param expression string with the RE
+   * @param tagged if true, every pair of brackets is surrounded by epsilon transitions tagging the capture group
+   * @return a NfaStructure, or error
+   */
+  static ErrOr<NfaStructure> generateNfaFromRE(const std::string& expression, bool print = false,
+                                               bool tagged = false);
+
+  /**
+   * Function that recursively transforms a parsed expression, for callers that already parsed it
+   * @param expr parsed expression
+   * @param tagged if true, every pair of brackets is surrounded by epsilon transitions tagging the capture group
    * @return a NfaStructure, or error
    */
-  static ErrOr<NfaStructure> generateNfaFromRE(const std::string& expression, bool print = false);
+  static ErrOr<NfaStructure> generateNfaFromExpression(const SPExpression& expr, bool tagged = false);
+
+  /**
+   * Function that creates a NFA accepting the reversed strings of this NFA, by flipping every transition. Nodes with
+   * more than one flipped transition leaving them get a tree of epsilon transitions. Tags are not kept
+   * @return reversed NfaStructure, sharing no nodes with this one
+   */
+  [[nodiscard]] NfaStructure reverse() const;
+
+  /**
+   * Function that creates a NFA accepting every string that ends with a string accepted by this NFA, by adding a
+   * loop on every byte before the starting node
+   * @return NfaStructure sharing all nodes of this one
+   */
+  [[nodiscard]] NfaStructure unanchored() const;
+
+  /**
+   * Function that removes the transitions of all nodes and empties the NFA. A '*' links the final node of its operand
+   * back to the start, so the nodes of an NFA with a closure are freed only after the cycle is broken this way
+   */
+  void releaseNodes();
 };
@@ -0,0 +1,124 @@
+#include "pattern_set.h"
+
+#include <algorithm>
+#include <set>
+
+void PatternSet::resetShard(Shard& shard) {
+  if (shard.removed) {
+    std::erase_if(shard.patterns, [this](const auto& pattern) { return !_patterns.contains(pattern->id); });
+    shard.removed = 0;
+  }
+  std::vector<SPNfaNode> starts;
+  for (const auto& pattern : shard.patterns) {
+    starts.push_back(pattern->nfa.getStart());
+  }
+  shard.start = starts.empty() ? nullptr : joinWithEpsilon(starts, 0, starts.size());
+  shard.state_ids.clear();
+  shard.states.clear();
+  shard.transitions.clear();
+  shard.accepted.clear();
+}
+
+size_t PatternSet::getState(Shard& shard, std::vector<NfaNode*> nodes) {
+  std::set<NfaNode*> closure;
+  while (!nodes.empty()) {
+    auto* node = nodes.back();
+    nodes.pop_back();
+    if (node == nullptr || !closure.insert(node).second) continue;
+    if (node->isEpsilon()) {
+      nodes.push_back(node->getLeft().get());
+      nodes.push_back(node->getRight().get());
+    }
+  }
+  std::vector<NfaNode*> key(closure.begin(), closure.end());
+  const auto& ret = shard.state_ids.find(key);
+  if (ret != shard.state_ids.end()) return ret->second;
+
+  std::vector<size_t> accepted;
+  for (const auto& node : key) {
+    const auto& final = _final_nodes.find(node);
+    if (final != _final_nodes.end()) accepted.push_back(final->second);
+  }
+  std::sort(accepted.begin(), accepted.end());
+  shard.accepted.push_back(std::move(accepted));
+  shard.transitions.emplace_back();
+  shard.transitions.back().fill(npos);
+  shard.states.push_back(key);
+  return shard.state_ids[std::move(key)] = shard.states.size() - 1;
+}
+
+size_t PatternSet::move(Shard& shard, size_t state, char symbol) {
+  auto& target = shard.transitions[state][static_cast<unsigned char>(symbol)];
+  if (target != npos) return target;
+  std::vector<NfaNode*> nodes;
+  for (const auto& node : shard.states[state]) {
+    if (node->hasTransitionOn(symbol)) nodes.push_back(node->getLeft().get());
+  }
+  auto next = getState(shard, std::move(nodes));
+  // getState may have reallocated the transitions, so the reference can't be used anymore
+  return shard.transitions[state][static_cast<unsigned char>(symbol)] = next;
+}
+
+ErrOr<size_t> PatternSet::add(const std::string& expression) {
+  auto nfa = NfaStructure::generateNfaFromRE(expression);
+  if (nfa.err) return *nfa.err;
+  auto pattern = std::make_shared<Pattern>(_next_id++, expression, std::move(*nfa.data));
+  _patterns[pattern->id] = pattern;
+  _final_nodes[pattern->nfa.getFinal().get()] = pattern->id;
+
+  // only the last shard accepts new patterns, so shards that are full keep their cached states
+  if (_shards.empty() || _shards.back().patterns.size() - _shards.back().removed >= _shard_capacity) {
+    _shards.emplace_back();
+  }
+  _shards.back().patterns.push_back(pattern);
+  resetShard(_shards.back());
+  return pattern->id;
+}
+
+bool PatternSet::remove(size_t id) {
+  const auto& ret = _patterns.find(id);
+  if (ret == _patterns.end()) return false;
+  auto final = ret->second->nfa.getFinal().get();
+  _patterns.erase(ret);
+  for (auto shard = _shards.begin(); shard != _shards.end(); ++shard) {
+    auto it = std::find_if(shard->patterns.begin(), shard->patterns.end(),
+                           [id](const auto& pattern) { return pattern->id == id; });
+    if (it == shard->patterns.end()) continue;
+    // cached states stay valid, the removed pattern is filtered out of the results until the shard is compacted
+    shard->removed++;
+    if (shard->removed == shard->patterns.size()) {
+      _shards.erase(shard);
+    } else if (2 * shard->removed > shard->patterns.size()) {
+      resetShard(*shard);
+    }
+    break;
+  }
+  // the final node is forgotten only after the shard no longer references the removed NFA
+  _final_nodes.erase(final);
+  return true;
+}
+
+std::vector<size_t> PatternSet::match(const std::string& expression) {
+  std::vector<size_t> ret;
+  for (auto& shard : _shards) {
+    if (shard.states.empty()) getState(shard, {shard.start.get()});
+    size_t state = 0;
+    for (const auto& symbol : expression) {
+      state = move(shard, state, symbol);
+      if (shard.states[state].empty()) break;
+    }
+    for (const auto& id : shard.accepted[state]) {
+      if (_patterns.contains(id)) ret.push_back(id);
+    }
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+size_t PatternSet::cachedStates() const {
+  size_t ret = 0;
+  for (const auto& shard : _shards) {
+    ret += shard.states.size();
+  }
+  return ret;
+}
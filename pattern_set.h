@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "errors.h"
+#include "nfa.h"
+
+/**
+ * Set of patterns matched together, which can be changed without recompiling the patterns that stay in the set.
+ * Every pattern keeps its own NFA. Patterns are grouped in shards, every shard links the NFAs of its patterns under
+ * a common starting node and determinizes them lazily, caching DFA states as the input needs them. Adding a pattern
+ * resets only the shard it is added to, removing a pattern leaves the cached states in place and only filters the
+ * pattern out of the results until enough patterns of the shard are removed to compact it
+ */
+class PatternSet {
+  struct Pattern {
+    size_t id;
+    std::string expression;
+    NfaStructure nfa;
+
+    Pattern(size_t id, std::string expression, NfaStructure nfa)
+        : id(id), expression(std::move(expression)), nfa(std::move(nfa)) {}
+    Pattern(const Pattern&) = delete;
+    Pattern& operator=(const Pattern&) = delete;
+    // the NFA is not shared with anything else, so its cycles are broken once the last shard drops the pattern
+    ~Pattern() { nfa.releaseNodes(); }
+  };
+
+  struct Shard {
+    std::vector<std::shared_ptr<Pattern>> patterns;  // patterns of the shard, including removed ones until compaction
+    size_t removed{0};                               // number of removed patterns still linked into the shard
+    SPNfaNode start;                                 // epsilon transitions to the starting nodes of all patterns
+    std::map<std::vector<NfaNode*>, size_t> state_ids;
+    std::vector<std::vector<NfaNode*>> states;        // NFA nodes of every cached DFA state
+    std::vector<std::array<size_t, 256>> transitions;  // target of every state and byte, npos if not built yet
+    std::vector<std::vector<size_t>> accepted;        // ids of the patterns accepted in every state
+  };
+
+  std::list<Shard> _shards;
+  std::map<size_t, std::shared_ptr<Pattern>> _patterns;  // patterns currently in the set
+  std::map<NfaNode*, size_t> _final_nodes;               // id of the pattern that given final NFA node belongs to
+  size_t _shard_capacity;
+  size_t _next_id{0};
+
+  /**
+   * Function that links the patterns of a shard that were not removed and drops all cached states of the shard
+   * @param shard shard to reset
+   */
+  void resetShard(Shard& shard);
+
+  /**
+   * Function that returns the cached state made of epsilon closure of given nodes, creating it if needed
+   * @param shard shard the state belongs to
+   * @param nodes NFA nodes of the state, before the epsilon closure
+   * @return index of the state
+   */
+  size_t getState(Shard& shard, std::vector<NfaNode*> nodes);
+
+  /**
+   * Function that returns the state that given state moves to on a byte, creating it if needed
+   * @param shard shard the state belongs to
+   * @param state index of the state
+   * @param symbol byte of the input
+   * @return index of the target state
+   */
+  size_t move(Shard& shard, size_t state, char symbol);
+
+ public:
+  /**
+   * @param shard_capacity maximum number of patterns determinized together
+   */
+  explicit PatternSet(size_t shard_capacity = 16) : _shard_capacity(shard_capacity) {}
+
+  /**
+   * Function that adds a pattern to the set
+   * @param expression string with the RE
+   * @return id of the pattern, or error if the pattern could not be parsed
+   */
+  ErrOr<size_t> add(const std::string& expression);
+
+  /**
+   * Function that removes a pattern from the set
+   * @param id id returned by add
+   * @return true if the pattern was in the set
+   */
+  bool remove(size_t id);
+
+  /**
+   * Function that checks which patterns accept given string. Not thread safe, states are cached during matching
+   * @param expression string to match
+   * @return sorted ids of all patterns that accept the whole string
+   */
+  std::vector<size_t> match(const std::string& expression);
+
+  [[nodiscard]] size_t size() const { return _patterns.size(); }
+
+  /**
+   * Function that returns the number of DFA states cached in all shards
+   * @return number of cached states
+   */
+  [[nodiscard]] size_t cachedStates() const;
+};
@@ -1,6 +1,17 @@
 #include "reg_exp.h"
 
-Expression::Expression(char value) : _type(ExprssionType::Value), _value(value) {}
+#include <algorithm>
+#include <sstream>
+
+Expression::Expression(char value) : _type(ExprssionType::Value), _value(value), _last_value(value) {}
+Expression::Expression(char value, char last_value)
+    : _type(ExprssionType::Value), _value(value), _last_value(last_value) {}
+std::string printableByte(char byte) {
+  if (byte >= 0x20 && byte < 0x7F) return std::string(1, byte);
+  std::ostringstream ret;
+  ret << "\\x" << std::hex << static_cast<int>(static_cast<unsigned char>(byte));
+  return ret.str();
+}
 const std::shared_ptr<Expression>& Expression::getLeft() { return _left; }
 const std::shared_ptr<Expression>& Expression::getRight() { return _right; }
 void Expression::starRightSide() { _right = std::make_shared<Expression>(ExprssionType::Star, std::move(_right)); }
@@ -9,7 +20,11 @@ void Expression::printTree(const std::string& prefix, bool is_right) {
   std::cout << (is_right ? "|--" : "L--");
   switch (_type) {
     case ExprssionType::Value: {
-      std::cout << _value << std::endl;
+      if (_value == _last_value) {
+        std::cout << printableByte(_value) << std::endl;
+      } else {
+        std::cout << "[" << printableByte(_value) << "-" << printableByte(_last_value) << "]" << std::endl;
+      }
       break;
     }
     case ExprssionType::Add: {
@@ -24,7 +39,9 @@ void Expression::printTree(const std::string& prefix, bool is_right) {
       break;
     }
     case ExprssionType::Brackets: {
-      std::cout << YELLOW << "Brackets" << RESET << std::endl;
+      std::cout << YELLOW << "Brackets";
+      if (_group) std::cout << " " << _group;
+      std::cout << RESET << std::endl;
       _left->printTree(prefix + (is_right ? "|   " : "    "), false);
       break;
     }
@@ -70,19 +87,16 @@ ErrOr<std::pair<std::string, SPExpression>> RegExpParser::parseExpression(std::s
       case '(': {
         expression.erase(0, 1);
         _open_bracets++;
-        auto ret = parseExpression(expression);
+        auto group = ++_groups;
+        auto ret = parseExpression(std::move(expression));
         if (ret.err) return *ret.err;
-        expression = ret.data.value().first;
+        expression = std::move(ret.data.value().first);
         if (expression.empty() || expression.at(0) != ')') {
           return ERROR_WITH_FILE("bracket not closed");
         }
-        auto expr = ret.data.value().second;
+        auto expr = std::move(ret.data.value().second);
         if (!expr) return ERROR_WITH_FILE("empty statement inside brackets is not allowed");
-        std::shared_ptr<Expression> temp;
-        if (expr->getType() == ExprssionType::Brackets)
-          temp = std::move(expr);
-        else
-          temp = std::make_shared<Expression>(ExprssionType::Brackets, std::move(expr));
+        auto temp = std::make_shared<Expression>(ExprssionType::Brackets, std::move(expr), group);
         curr == nullptr ? curr = std::move(temp)
                         : curr = std::make_shared<Expression>(ExprssionType::Add, std::move(curr), std::move(temp));
 
@@ -90,14 +104,14 @@ ErrOr<std::pair<std::string, SPExpression>> RegExpParser::parseExpression(std::s
       }
       case ')': {
         if (!_open_bracets--) return ERROR_WITH_FILE("closing bracket doesn't have an opening bracked");
-        return std::make_pair(expression, std::move(curr));
+        return std::make_pair(std::move(expression), std::move(curr));
       }
       case '|': {
         if (curr == nullptr) return ERROR_WITH_FILE("OR called without anything before");
         expression.erase(0, 1);
-        auto ret = parseExpression(expression);
+        auto ret = parseExpression(std::move(expression));
         if (ret.err) return *ret.err;
-        expression = ret.data.value().first;
+        expression = std::move(ret.data.value().first);
         if (!expression.empty() && expression.at(0) != ')') {
           return ERROR_WITH_FILE("OR expression not parsed correctly");
         }
@@ -107,16 +121,98 @@ ErrOr<std::pair<std::string, SPExpression>> RegExpParser::parseExpression(std::s
           return ERROR_WITH_FILE("OR expression rhs is empty");
         }
         curr = std::make_shared<Expression>(ExprssionType::Or, std::move(curr), std::move(rhs));
-        return std::make_pair(expression, std::move(curr));
+        return std::make_pair(std::move(expression), std::move(curr));
+      }
+      case '[': {
+        expression.erase(0, 1);
+        auto ret = parseClass(expression);
+        if (ret.err) return *ret.err;
+        auto temp = std::move(*ret.data);
+        curr == nullptr ? curr = std::move(temp)
+                        : curr = std::make_shared<Expression>(ExprssionType::Add, std::move(curr), std::move(temp));
+        break;
       }
       default: {
-        auto temp = std::make_shared<Expression>(expression.at(0));
+        uint32_t code_point;
+        auto length = decodeUtf8(expression, 0, code_point);
+        if (!length) return ERROR_WITH_FILE("invalid UTF-8 sequence");
+        Utf8Sequence sequence;
+        for (size_t i = 0; i < length; ++i) sequence.emplace_back(expression.at(i), expression.at(i));
+        auto temp = sequenceToExpression(sequence);
         curr == nullptr ? curr = std::move(temp)
                         : curr = std::make_shared<Expression>(ExprssionType::Add, std::move(curr), std::move(temp));
+        expression.erase(0, length - 1);
         break;
       }
     }
     expression.erase(0, 1);
   }
-  return std::make_pair(expression, std::move(curr));
+  return std::make_pair(std::move(expression), std::move(curr));
+}
+
+SPExpression RegExpParser::sequenceToExpression(const Utf8Sequence& sequence) {
+  SPExpression ret;
+  for (const auto& [first, last] : sequence) {
+    auto temp = std::make_shared<Expression>(static_cast<char>(first), static_cast<char>(last));
+    ret == nullptr ? ret = std::move(temp)
+                   : ret = std::make_shared<Expression>(ExprssionType::Add, std::move(ret), std::move(temp));
+  }
+  if (sequence.size() == 1) return ret;
+  // brackets make a kleene closure apply to the whole character instead of its last byte
+  return std::make_shared<Expression>(ExprssionType::Brackets, std::move(ret), 0);
+}
+
+ErrOr<SPExpression> RegExpParser::parseClass(std::string& expression) {
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  bool negated = !expression.empty() && expression.at(0) == '^';
+  if (negated) expression.erase(0, 1);
+  while (!expression.empty() && expression.at(0) != ']') {
+    uint32_t first;
+    auto length = decodeUtf8(expression, 0, first);
+    if (!length) return ERROR_WITH_FILE("invalid UTF-8 sequence in character class");
+    expression.erase(0, length);
+    auto last = first;
+    if (expression.size() > 1 && expression.at(0) == '-' && expression.at(1) != ']') {
+      length = decodeUtf8(expression, 1, last);
+      if (!length) return ERROR_WITH_FILE("invalid UTF-8 sequence in character class");
+      if (last < first) return ERROR_WITH_FILE("character class range out of order");
+      expression.erase(0, length + 1);
+    }
+    ranges.emplace_back(first, last);
+  }
+  if (expression.empty()) return ERROR_WITH_FILE("character class not closed");
+  if (ranges.empty()) return ERROR_WITH_FILE("empty character class is not allowed");
+
+  std::sort(ranges.begin(), ranges.end());
+  std::vector<std::pair<uint32_t, uint32_t>> merged;
+  for (const auto& range : ranges) {
+    if (!merged.empty() && range.first <= merged.back().second + 1) {
+      merged.back().second = std::max(merged.back().second, range.second);
+    } else {
+      merged.push_back(range);
+    }
+  }
+  if (negated) {
+    std::vector<std::pair<uint32_t, uint32_t>> complement;
+    uint32_t next = 0;
+    for (const auto& [first, last] : merged) {
+      if (first > next) complement.emplace_back(next, first - 1);
+      next = last + 1;
+    }
+    if (next <= MAX_CODE_POINT) complement.emplace_back(next, MAX_CODE_POINT);
+    merged = std::move(complement);
+  }
+
+  std::vector<Utf8Sequence> sequences;
+  for (const auto& [first, last] : merged) {
+    splitUtf8Range(first, last, sequences);
+  }
+  if (sequences.empty()) return ERROR_WITH_FILE("character class doesn't match any character");
+  // alternatives are nested to the right, the same way the parser builds them for '|'
+  SPExpression ret = sequenceToExpression(sequences.back());
+  for (auto it = std::next(sequences.rbegin()); it != sequences.rend(); ++it) {
+    ret = std::make_shared<Expression>(ExprssionType::Or, sequenceToExpression(*it), std::move(ret));
+  }
+  if (sequences.size() == 1) return ret;
+  return SPExpression(std::make_shared<Expression>(ExprssionType::Brackets, std::move(ret), 0));
 }
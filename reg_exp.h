@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "errors.h"
+#include "utf8.h"
 
 enum class ExprssionType {
   Value,
@@ -17,6 +18,9 @@ class Expression {
   std::shared_ptr<Expression> _left;
   std::shared_ptr<Expression> _right;
   char _value{};
+  char _last_value{};  // last byte of the range matched by a value, equal to _value for a single character
+  size_t _group{};  // index of the capture group opened by brackets, groups are numbered from 1 in order of '(' and
+                    // 0 marks brackets added by the parser around multibyte characters and classes
 
  public:
   // constructor for concat and or
@@ -25,22 +29,58 @@ class Expression {
 
   // constructor for star
   Expression(ExprssionType type, std::shared_ptr<Expression> left) : _type(type), _left(std::move(left)) {}
+  // constructor for brackets
+  Expression(ExprssionType type, std::shared_ptr<Expression> left, size_t group)
+      : _type(type), _left(std::move(left)), _group(group) {}
   // constructor for value
   explicit Expression(char value);
+  // constructor for value matching a range of bytes
+  Expression(char value, char last_value);
 
   const std::shared_ptr<Expression>& getLeft();
   const std::shared_ptr<Expression>& getRight();
   ExprssionType getType() { return _type; }
   [[nodiscard]] const char& getValue() const { return _value; }
+  [[nodiscard]] const char& getLastValue() const { return _last_value; }
+  [[nodiscard]] size_t getGroup() const { return _group; }
   void starRightSide();
   void printTree(const std::string& prefix = "", bool is_right = false);
 };
 
 typedef std::shared_ptr<Expression> SPExpression;
 
+/**
+ * Function that returns a printable representation of a byte
+ * @param byte byte to print
+ * @return the character itself if it is printable ASCII, its hex value otherwise
+ */
+std::string printableByte(char byte);
+
 class RegExpParser {
   size_t _open_bracets{0};
+  size_t _groups{0};
+
+  /**
+   * Function that parses a character class, '[' followed by UTF-8 characters and ranges 'a-z', optionally negated
+   * with '^', into an expression matching the UTF-8 encoding of every code point of the class
+   * @param expression string starting after the '[', the parsed class is erased up to the closing ']'
+   * @return expression, or error
+   */
+  static ErrOr<SPExpression> parseClass(std::string& expression);
+
+  /**
+   * Function that transforms a sequence of byte ranges into an expression
+   * @param sequence byte ranges, each matched by a single value
+   * @return expression, concatenation of the values wrapped in brackets if there is more than a single byte
+   */
+  static SPExpression sequenceToExpression(const Utf8Sequence& sequence);
 
  public:
   ErrOr<std::pair<std::string, SPExpression>> parseExpression(std::string expression);
+
+  /**
+   * Function that returns the number of capture groups (pairs of brackets) found by the parser
+   * @return number of capture groups
+   */
+  [[nodiscard]] size_t getGroupCount() const { return _groups; }
 };
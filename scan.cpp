@@ -0,0 +1,197 @@
+#include "scan.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+ErrOr<FileScanner> FileScanner::generateScannerFromRE(const std::string& expression, bool count_only,
+                                                      size_t threads) {
+  auto searcher = DfaSearcher::generateSearcherFromRE(expression);
+  if (searcher.err) {
+    return *searcher.err;
+  }
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  return FileScanner(std::move(*searcher.data), count_only, threads);
+}
+
+/**
+ * Output shared by the threads of scanFiles. Only the thread of the front file, the first file that is not printed
+ * completely, writes to the stream, files finished before their turn wait in finished
+ */
+struct FileScanner::Printer {
+  const std::vector<std::string>& files;
+  std::ostream& out;
+  std::ostream& errors;
+  bool count_only;
+  std::mutex mutex;
+  std::condition_variable advanced;
+  std::atomic<size_t> front{0};
+  std::atomic<size_t> matches{0};
+  std::atomic<size_t> failed{0};
+  std::vector<std::optional<ScanResult>> finished;
+
+  Printer(const std::vector<std::string>& files, std::ostream& out, std::ostream& errors, bool count_only)
+      : files(files), out(out), errors(errors), count_only(count_only), finished(files.size()) {}
+
+  /**
+   * Function that checks if a file is the front file
+   * @param index position of the file
+   * @return true, if every file before it is printed
+   */
+  [[nodiscard]] bool isFront(size_t index) const { return front.load(std::memory_order_acquire) == index; }
+
+  /**
+   * Function that blocks until every file before the given one is printed
+   * @param index position of the file
+   */
+  void waitForTurn(size_t index) {
+    std::unique_lock lock(mutex);
+    advanced.wait(lock, [this, index]() { return isFront(index); });
+  }
+
+  /**
+   * Function that blocks until a file is close enough to the front file to be started
+   * @param index position of the file
+   * @param window number of files that may be started ahead of the front file
+   */
+  void waitForWindow(size_t index, size_t window) {
+    std::unique_lock lock(mutex);
+    advanced.wait(lock, [this, index, window]() { return index < front.load(std::memory_order_acquire) + window; });
+  }
+
+  /**
+   * Function that prints the lines of the front file that wait to be printed
+   * @param index position of the front file
+   * @param lines lines to print, cleared afterwards
+   */
+  void printLines(size_t index, std::vector<std::string_view>& lines) {
+    for (const auto& line : lines) {
+      if (files.size() > 1) out << files[index] << ":";
+      out << line << "\n";
+    }
+    lines.clear();
+  }
+
+  /**
+   * Function that takes a scanned file. The front file is printed, together with every file after it that finished
+   * already, any other file waits in finished until its turn
+   * @param index position of the file
+   * @param result result of the file
+   */
+  void finish(size_t index, ScanResult result) {
+    {
+      std::lock_guard lock(mutex);
+      if (!isFront(index)) {
+        if (result.lines.empty()) result.mapping.reset();
+        finished[index] = std::move(result);
+        return;
+      }
+    }
+    for (;;) {
+      if (result.err) {
+        errors << RED << "ERROR, " << SMALLRED << result.err->msg << RESET << "\n";
+        failed++;
+      } else if (count_only) {
+        if (files.size() > 1) out << files[index] << ":";
+        out << result.count << "\n";
+      } else {
+        printLines(index, result.lines);
+      }
+      matches += result.count;
+      result = ScanResult();
+
+      std::lock_guard lock(mutex);
+      front.store(++index, std::memory_order_release);
+      advanced.notify_all();
+      if (index == files.size() || !finished[index]) return;
+      result = std::move(*finished[index]);
+      finished[index].reset();
+    }
+  }
+};
+
+void FileScanner::scanText(size_t index, std::string_view text, ScanResult& result, Printer& printer) const {
+  static const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t released = 0;
+  for (size_t begin = 0; begin < text.size();) {
+    if (begin - released >= SCAN_RELEASE_BYTES && result.lines.empty()) {
+      auto end = begin / page * page;
+      madvise(const_cast<char*>(text.data()) + released, end - released, MADV_DONTNEED);
+      released = end;
+    }
+    const auto* newline = static_cast<const char*>(std::memchr(text.data() + begin, '\n', text.size() - begin));
+    auto end = newline ? static_cast<size_t>(newline - text.data()) : text.size();
+    auto line = text.substr(begin, end - begin);
+    begin = end + 1;
+    if (!_searcher.find(line)) continue;
+    result.count++;
+    if (_count_only) continue;
+    result.lines.push_back(line);
+    if (result.lines.size() >= SCAN_PENDING_LINES) printer.waitForTurn(index);
+    if (printer.isFront(index)) printer.printLines(index, result.lines);
+  }
+}
+
+void FileScanner::scanFile(size_t index, const std::string& file, Printer& printer) const {
+  ScanResult result;
+  auto fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    result.err = ERROR_WITH_FILE("file '" + file + "' could not be opened");
+    printer.finish(index, std::move(result));
+    return;
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    result.err = ERROR_WITH_FILE("'" + file + "' is not a regular file");
+    printer.finish(index, std::move(result));
+    return;
+  }
+  auto size = static_cast<size_t>(info.st_size);
+  if (size == 0) {
+    close(fd);
+    printer.finish(index, std::move(result));
+    return;
+  }
+  auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    result.err = ERROR_WITH_FILE("file '" + file + "' could not be mapped");
+    printer.finish(index, std::move(result));
+    return;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+  result.mapping = std::shared_ptr<const char>(static_cast<const char*>(data),
+                                               [size](const char* mapped) { munmap(const_cast<char*>(mapped), size); });
+  scanText(index, std::string_view(result.mapping.get(), size), result, printer);
+  printer.finish(index, std::move(result));
+}
+
+ScanTotals FileScanner::scanFiles(const std::vector<std::string>& files, std::ostream& out,
+                                  std::ostream& errors) const {
+  Printer printer(files, out, errors, _count_only);
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (auto i = next++; i < files.size(); i = next++) {
+      printer.waitForWindow(i, _threads * SCAN_FILES_AHEAD);
+      scanFile(i, files[i], printer);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t i = 0; i < std::min(_threads, files.size()); ++i) {
+    pool.emplace_back(worker);
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  return {printer.matches, printer.failed};
+}
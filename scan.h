@@ -0,0 +1,86 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search.h"
+
+constexpr size_t SCAN_FILES_AHEAD = 2;            // files every thread may start ahead of the file being printed
+constexpr size_t SCAN_PENDING_LINES = 64 * 1024;  // matching lines a file keeps before it waits to be printed
+constexpr size_t SCAN_RELEASE_BYTES = 4 << 20;    // scanned bytes of a mapping given back at once
+
+/**
+ * Result of scanning a single file
+ */
+struct ScanResult {
+  OErr err;                             // set if the file could not be read
+  size_t count{0};                      // number of matching lines
+  std::shared_ptr<const char> mapping;  // file mapped into memory, kept while lines wait to be printed
+  std::vector<std::string_view> lines;  // matching lines inside the mapping, empty in count only mode
+};
+
+/**
+ * Totals of scanning files
+ */
+struct ScanTotals {
+  size_t matches{0};  // number of matching lines in all files
+  size_t failed{0};   // number of files that could not be read
+};
+
+/**
+ * Scanner reporting the lines of files that contain a match of an expression, like grep. The expression is compiled
+ * once and shared by a pool of threads, each file is mapped into memory and split into lines with memchr. Results are
+ * printed in the order of the files: the first file that is not printed yet writes its lines directly while it is
+ * scanned, the files after it keep their lines as views into the mapping until their turn
+ */
+class FileScanner {
+  struct Printer;  // output shared by the threads of scanFiles
+
+  DfaSearcher _searcher;
+  bool _count_only;
+  size_t _threads;
+
+  FileScanner(DfaSearcher searcher, bool count_only, size_t threads)
+      : _searcher(std::move(searcher)), _count_only(count_only), _threads(threads) {}
+
+  /**
+   * Function that scans a single file and hands the result to the printer
+   * @param index position of the file in the output
+   * @param file path of the file
+   * @param printer output shared by the threads
+   */
+  void scanFile(size_t index, const std::string& file, Printer& printer) const;
+
+  /**
+   * Function that scans all lines of a text. Once no matching line waits to be printed, the pages scanned so far are
+   * given back, so a large file doesn't stay resident
+   * @param index position of the file in the output
+   * @param text content of a file
+   * @param result result the matching lines are added to
+   * @param printer output the lines are printed to as soon as it is the turn of the file
+   */
+  void scanText(size_t index, std::string_view text, ScanResult& result, Printer& printer) const;
+
+ public:
+  /**
+   * Function that generates a scanner from a string
+   * @param expression string with the expression
+   * @param count_only true if only the number of matching lines is reported
+   * @param threads number of threads scanning files, 0 to use one per hardware thread
+   * @return FileScanner or error
+   */
+  static ErrOr<FileScanner> generateScannerFromRE(const std::string& expression, bool count_only = false,
+                                                  size_t threads = 0);
+
+  /**
+   * Function that scans files in parallel and prints the results in the order of the files. Lines are prefixed with
+   * the name of the file if there is more than one file. Threads start at most SCAN_FILES_AHEAD files each ahead of
+   * the file being printed
+   * @param files paths of the files
+   * @param out stream the results are printed to
+   * @param errors stream the files that could not be read are reported to, so they don't mix with the results
+   * @return number of matching lines and of files that could not be read
+   */
+  ScanTotals scanFiles(const std::vector<std::string>& files, std::ostream& out, std::ostream& errors) const;
+};
@@ -0,0 +1,119 @@
+#include "search.h"
+
+constexpr size_t MAX_SUFFIX = 256;
+
+ErrOr<DfaSearcher> DfaSearcher::generateSearcherFromRE(const std::string& expression) {
+  RegExpParser parser;
+  auto parsed = parser.parseExpression(expression);
+  if (parsed.err) {
+    return *parsed.err;
+  }
+  // a single literal is left to the suffix search, which skips ahead further than the literal searcher
+  std::vector<std::string> literals;
+  if (LiteralSearcher::extractLiterals(parsed.data.value().second, literals) && literals.size() > 1) {
+    return DfaSearcher(LiteralSearcher(std::move(literals)));
+  }
+
+  auto nfa = NfaStructure::generateNfaFromRE(expression);
+  if (nfa.err) {
+    return *nfa.err;
+  }
+  auto unanchored = (*nfa.data).unanchored();
+  auto reversed = (*nfa.data).reverse();
+  DfaSearcher searcher(DFA::generateDfaFromNfa(unanchored), DFA::generateDfaFromNfa(reversed));
+  // the unanchored NFA shares the nodes of the original one, so releasing it releases both
+  unanchored.releaseNodes();
+  reversed.releaseNodes();
+  return searcher;
+}
+
+DfaSearcher::DfaSearcher(const DFA& forward, const DFA& reverse)
+    : _forward(forward.getMatcher()), _reverse(reverse.getMatcher()) {
+  findSuffix(reverse);
+}
+
+void DfaSearcher::findSuffix(const DFA& reverse) {
+  auto state = reverse.getStartState();
+  while (!reverse.isFinalState(state) && _suffix.size() < MAX_SUFFIX) {
+    size_t moves = 0;
+    char symbol{};
+    for (int i = 0; i < 256; ++i) {
+      if (reverse.nextState(state, static_cast<char>(i)) == reverse.getTrapState()) continue;
+      moves++;
+      symbol = static_cast<char>(i);
+    }
+    if (moves != 1) break;
+    _suffix += symbol;
+    state = reverse.nextState(state, symbol);
+  }
+  _suffix = std::string(_suffix.rbegin(), _suffix.rend());
+
+  // Horspool shifts, the last byte of the suffix is not taken into account so the shift is never 0
+  _skip.fill(_suffix.size());
+  for (size_t i = 0; i + 1 < _suffix.size(); ++i) {
+    _skip[static_cast<unsigned char>(_suffix[i])] = _suffix.size() - 1 - i;
+  }
+}
+
+bool DfaSearcher::findStart(std::string_view text, size_t end, size_t min_start, size_t& start) const {
+  return std::visit(
+      [text, end, min_start, &start](const auto& reverse) {
+        auto state = reverse.getStart();
+        start = reverse.isFinal(state) ? end : npos;
+        for (auto i = end; i > min_start; --i) {
+          state = reverse.next(state, text[i - 1]);
+          if (state == reverse.getTrap()) return false;
+          if (reverse.isFinal(state)) start = i - 1;
+        }
+        return true;
+      },
+      *_reverse);
+}
+
+std::optional<std::pair<size_t, size_t>> DfaSearcher::findForward(std::string_view text, size_t from) const {
+  auto end = std::visit(
+      [text, from](const auto& forward) {
+        auto state = forward.getStart();
+        auto end = from;
+        while (!forward.isFinal(state)) {
+          if (end == text.size() || state == forward.getTrap()) return npos;
+          state = forward.next(state, text[end++]);
+        }
+        return end;
+      },
+      *_forward);
+  if (end == npos) return std::nullopt;
+  size_t start;
+  findStart(text, end, from, start);
+  return std::make_pair(start, end);
+}
+
+std::optional<std::pair<size_t, size_t>> DfaSearcher::findBySuffix(std::string_view text, size_t from) const {
+  auto length = _suffix.size();
+  auto min_start = from;
+  auto position = from;
+  while (position + length <= text.size()) {
+    auto last = text[position + length - 1];
+    if (last != _suffix.back() || text.compare(position, length, _suffix) != 0) {
+      position += _skip[static_cast<unsigned char>(last)];
+      continue;
+    }
+    auto end = position + length;
+    size_t start;
+    auto reached_min_start = findStart(text, end, min_start, start);
+    // the reverse DFA was stopped before finishing, running the forward DFA once keeps the search linear
+    if (reached_min_start && min_start != from) return findForward(text, from);
+    if (start != npos) return std::make_pair(start, end);
+    // no match ends here, so the reverse DFA of the next occurrence doesn't have to go back further than that
+    min_start = end;
+    position++;
+  }
+  return std::nullopt;
+}
+
+std::optional<std::pair<size_t, size_t>> DfaSearcher::find(std::string_view text, size_t from) const {
+  if (from > text.size()) return std::nullopt;
+  if (_literals) return _literals->find(text, from);
+  if (_suffix.empty()) return findForward(text, from);
+  return findBySuffix(text, from);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <optional>
+
+#include "dfa.h"
+#include "literals.h"
+
+/**
+ * Searcher finding matches of an expression anywhere in a text in linear time. A forward DFA, with a loop on every
+ * byte before the expression, finds where the first match ends. The reverse DFA then walks back from that position
+ * to the leftmost position the match can start at. If every match ends with the same string of bytes, occurrences of
+ * that suffix are looked up first, skipping ahead on mismatch, and only the reverse DFA runs from each occurrence.
+ * Both DFAs run on their compiled matchers with narrow state ids, one byte at a time since a search has to stop at the
+ * first final state. Expressions that are only an alternation of literals don't build the DFAs and are searched by a
+ * LiteralSearcher
+ */
+class DfaSearcher {
+  std::optional<CompiledMatcher> _forward;  // only the narrow tables of the DFAs are kept
+  std::optional<CompiledMatcher> _reverse;
+  std::optional<LiteralSearcher> _literals;
+  std::string _suffix;           // bytes that every match ends with, empty if there are none
+  std::array<size_t, 256> _skip{};  // how far the suffix can move when the byte under its last position mismatches
+
+  DfaSearcher(const DFA& forward, const DFA& reverse);
+  explicit DfaSearcher(LiteralSearcher literals) : _literals(std::move(literals)) {}
+
+  /**
+   * Function that finds the suffix shared by all matches, by following the reverse DFA while only one byte moves it
+   * @param reverse reverse DFA
+   */
+  void findSuffix(const DFA& reverse);
+
+  /**
+   * Function that runs the reverse DFA backwards from the end of a match
+   * @param text text to search
+   * @param end position the match ends at
+   * @param min_start position the reverse DFA is not allowed to pass
+   * @param start set to the leftmost start found, or npos
+   * @return true if the reverse DFA reached min_start without getting to the trap state
+   */
+  bool findStart(std::string_view text, size_t end, size_t min_start, size_t& start) const;
+
+  /**
+   * Function that searches with the forward DFA first and the reverse DFA after it
+   */
+  [[nodiscard]] std::optional<std::pair<size_t, size_t>> findForward(std::string_view text, size_t from) const;
+
+  /**
+   * Function that searches for the occurrences of the suffix and runs the reverse DFA from each of them
+   */
+  [[nodiscard]] std::optional<std::pair<size_t, size_t>> findBySuffix(std::string_view text, size_t from) const;
+
+ public:
+  /**
+   * Function that generates a searcher from a string
+   * @param expression string with the expression
+   * @return DfaSearcher or error
+   */
+  static ErrOr<DfaSearcher> generateSearcherFromRE(const std::string& expression);
+
+  /**
+   * Function that finds the match that ends first in a text, and for that end the leftmost start
+   * @param text text to search
+   * @param from position to start searching at, matches starting before it are not found
+   * @return start and end (exclusive) of the match, or nullopt if there is none
+   */
+  [[nodiscard]] std::optional<std::pair<size_t, size_t>> find(std::string_view text, size_t from = 0) const;
+
+  [[nodiscard]] const std::string& getSuffix() const { return _suffix; }
+  [[nodiscard]] const std::optional<LiteralSearcher>& getLiteralSearcher() const { return _literals; }
+};
@@ -0,0 +1,144 @@
+#include "tagged_dfa.h"
+
+#include <algorithm>
+
+void TaggedDFA::epsilonClosure(NfaNode* node, std::vector<size_t>& tags, std::set<NfaNode*>& visited,
+                               std::vector<std::pair<NfaNode*, std::vector<size_t>>>& out) const {
+  if (node == nullptr || !visited.insert(node).second) return;
+  if (!node->isEpsilon()) {
+    out.emplace_back(node, tags);
+    return;
+  }
+  if (node->getTag()) tags.push_back(node->getTag());
+  epsilonClosure(node->getLeft().get(), tags, visited, out);
+  if (node->getRight()) epsilonClosure(node->getRight().get(), tags, visited, out);
+  if (node->getTag()) tags.pop_back();
+}
+size_t TaggedDFA::getState(const Configurations& configurations) {
+  const auto& ret = _state_ids.find(configurations);
+  if (ret != _state_ids.end()) return ret->second;
+  _states.push_back(configurations);
+  _transitions.emplace_back();
+  _transitions.back().fill(npos);
+  _final_slots.push_back(npos);
+  for (size_t slot = 0; slot < configurations.size(); ++slot) {
+    if (configurations[slot]->getLeft() == nullptr) _final_slots.back() = slot;
+  }
+  return _state_ids[configurations] = _states.size() - 1;
+}
+void TaggedDFA::applyTransition(const TaggedTransition& move, size_t position, const std::vector<size_t>& registers,
+                                std::vector<size_t>& next) const {
+  next.assign(move.sources.size() * _num_of_tags, npos);
+  for (size_t slot = 0; slot < move.sources.size(); ++slot) {
+    if (!registers.empty()) {
+      std::copy_n(registers.begin() + move.sources[slot] * _num_of_tags, _num_of_tags,
+                  next.begin() + slot * _num_of_tags);
+    }
+    for (const auto& tag : move.tags[slot]) {
+      next[slot * _num_of_tags + tag - 1] = position;
+    }
+  }
+}
+TaggedDFA TaggedDFA::generateTaggedDfaFromNfa(const NfaStructure& nfa) {
+  TaggedDFA dfa;
+  if (nfa.getStart() == nullptr) return dfa;
+  dfa._nfa_start = nfa.getStart();
+  dfa._num_of_tags = 2 * nfa.getGroupCount();
+
+  std::vector<size_t> tags;
+  std::set<NfaNode*> visited;
+  std::vector<std::pair<NfaNode*, std::vector<size_t>>> out;
+  dfa.epsilonClosure(nfa.getStart().get(), tags, visited, out);
+  Configurations configurations;
+  for (auto& [node, node_tags] : out) {
+    configurations.push_back(node);
+    dfa._initial.sources.push_back(0);
+    dfa._initial.tags.push_back(std::move(node_tags));
+  }
+  dfa._initial.target = dfa.getState(configurations);
+
+  // states are appended while iterating, so every state created on the way is also processed
+  for (size_t state = 0; state < dfa._states.size(); ++state) {
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      TaggedTransition move;
+      Configurations target;
+      visited.clear();
+      for (size_t slot = 0; slot < dfa._states[state].size(); ++slot) {
+        auto* node = dfa._states[state][slot];
+        if (node->getLeft() == nullptr || !node->hasTransitionOn(static_cast<char>(symbol))) continue;
+        out.clear();
+        dfa.epsilonClosure(node->getLeft().get(), tags, visited, out);
+        for (auto& [next, next_tags] : out) {
+          target.push_back(next);
+          move.sources.push_back(slot);
+          move.tags.push_back(std::move(next_tags));
+        }
+      }
+      if (target.empty()) continue;
+      move.target = dfa.getState(target);
+      dfa._transitions[state][symbol] = dfa._moves.size();
+      dfa._moves.push_back(std::move(move));
+    }
+  }
+  return dfa;
+}
+ErrOr<TaggedDFA> TaggedDFA::generateTaggedDfaFromRE(const std::string& expression, bool print) {
+  auto nfa = NfaStructure::generateNfaFromRE(expression, print, true);
+  if (nfa.err) {
+    return *nfa.err;
+  }
+  if (print) (*nfa.data).print();
+  return generateTaggedDfaFromNfa(nfa.data.value());
+}
+void TaggedDFA::print() {
+  std::cout << "Printing tagged DFA transitions\nEvery state is listed with ids of its NFA nodes, the starting state is "
+               "state 0 and final states are written with color "
+            << RED << "red" << RESET << ". Slot j of the target copies the registers of slot 'from' of the "
+            << "source state and sets listed tags\n\n";
+  for (size_t state = 0; state < _states.size(); ++state) {
+    std::cout << (_final_slots[state] != npos ? RED : YELLOW) << "state " << state << RESET << " {";
+    for (const auto& node : _states[state]) {
+      std::cout << " " << node->getId();
+    }
+    std::cout << " }\n";
+    for (size_t symbol = 0; symbol < 256; ++symbol) {
+      if (_transitions[state][symbol] == npos) continue;
+      const auto& move = _moves[_transitions[state][symbol]];
+      std::cout << "  on '" << YELLOW << printableByte(static_cast<char>(symbol)) << RESET << "' to state " << move.target << ":";
+      for (size_t slot = 0; slot < move.sources.size(); ++slot) {
+        std::cout << " [" << slot << " from " << move.sources[slot];
+        for (const auto& tag : move.tags[slot]) {
+          std::cout << " t" << tag;
+        }
+        std::cout << "]";
+      }
+      std::cout << "\n";
+    }
+  }
+  std::cout << "\n";
+}
+bool TaggedDFA::parseExpression(const std::string& expression, std::vector<Submatch>& groups) const {
+  if (_states.empty()) return false;
+  std::vector<size_t> registers;
+  std::vector<size_t> next;
+  applyTransition(_initial, 0, next, registers);
+  auto state = _initial.target;
+  for (size_t i = 0; i < expression.size(); ++i) {
+    auto index = _transitions[state][static_cast<unsigned char>(expression[i])];
+    if (index == npos) return false;
+    const auto& move = _moves[index];
+    applyTransition(move, i + 1, registers, next);
+    registers.swap(next);
+    state = move.target;
+  }
+  auto slot = _final_slots[state];
+  if (slot == npos) return false;
+  groups.assign(_num_of_tags / 2 + 1, Submatch());
+  groups[0] = {0, expression.size(), true};
+  for (size_t group = 1; group < groups.size(); ++group) {
+    auto open = registers[slot * _num_of_tags + 2 * group - 2];
+    auto close = registers[slot * _num_of_tags + 2 * group - 1];
+    if (open != npos && close != npos) groups[group] = {open, close, true};
+  }
+  return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "errors.h"
+#include "nfa.h"
+
+struct Submatch {
+  size_t start{};
+  size_t end{};
+  bool matched{false};  // false if the capture group did not take part in the match
+};
+
+/**
+ * Transition of a tagged DFA. Every configuration (slot) of the target state copies the registers of one slot of the
+ * source state and then stores the current position in the registers of all tags passed on the way
+ */
+struct TaggedTransition {
+  size_t target{};
+  std::vector<size_t> sources;           // for every slot of the target state, slot of the source state it came from
+  std::vector<std::vector<size_t>> tags;  // for every slot of the target state, tags set at the current position
+};
+
+class TaggedDFA {
+  // configuration of a state, NFA node which is either the final node or has a transition on a symbol
+  typedef std::vector<NfaNode*> Configurations;
+
+  std::vector<Configurations> _states;                  // configurations of every state, in priority order
+  std::map<Configurations, size_t> _state_ids;          // id of a state with given configurations
+  std::vector<std::array<size_t, 256>> _transitions;    // index into _moves for every state and byte, or npos
+  std::vector<TaggedTransition> _moves;                 // all transitions of the DFA
+  std::vector<size_t> _final_slots;                     // slot of the final NFA node in every state, or npos
+  TaggedTransition _initial;                            // transition from nothing into the starting state
+  SPNfaNode _nfa_start;                                 // keeps the NFA nodes referenced by the states alive
+  size_t _num_of_tags{};
+
+  TaggedDFA() = default;
+
+  /**
+   * Function that performs a depth first epsilon closure, reaching nodes in priority order (left before right)
+   * @param node node to start from
+   * @param tags tags passed on the way to the node
+   * @param visited nodes already reached by a path with higher priority
+   * @param out configurations reached, together with the tags passed on the way to them
+   */
+  void epsilonClosure(NfaNode* node, std::vector<size_t>& tags, std::set<NfaNode*>& visited,
+                      std::vector<std::pair<NfaNode*, std::vector<size_t>>>& out) const;
+
+  /**
+   * Function that returns the id of a state with given configurations, creating the state if it doesn't exist yet
+   * @param configurations configurations of the state
+   * @return id of the state
+   */
+  size_t getState(const Configurations& configurations);
+
+  /**
+   * Function that applies a transition to the registers
+   * @param move transition to apply
+   * @param position current position in the input
+   * @param registers registers of the source state
+   * @param next registers of the target state
+   */
+  void applyTransition(const TaggedTransition& move, size_t position, const std::vector<size_t>& registers,
+                       std::vector<size_t>& next) const;
+
+ public:
+  /**
+   * Function that generates a tagged DFA from a NFA generated with tags
+   * @param nfa NfaStructure object
+   * @return TaggedDFA
+   */
+  static TaggedDFA generateTaggedDfaFromNfa(const NfaStructure& nfa);
+
+  /**
+   * Function that generates a tagged DFA from a string
+   * @param expression string with the expression
+   * @return TaggedDFA or error
+   */
+  static ErrOr<TaggedDFA> generateTaggedDfaFromRE(const std::string& expression, bool print = false);
+
+  void print();
+
+  /**
+   * Function that checks if given string is accepted by the DFA, and extracts the capture groups in the same pass
+   * @param expression string with the expression
+   * @param groups filled with the submatches, group 0 is the whole string and group g is the g-th pair of brackets
+   * @return true, if string can be accepted
+   */
+  bool parseExpression(const std::string& expression, std::vector<Submatch>& groups) const;
+};
@@ -0,0 +1,95 @@
+#include "utf8.h"
+
+size_t decodeUtf8(const std::string& str, size_t pos, uint32_t& code_point) {
+  auto lead = static_cast<uint8_t>(str.at(pos));
+  size_t length;
+  uint32_t min_value;
+  if (lead < 0x80) {
+    code_point = lead;
+    return 1;
+  } else if ((lead & 0xE0) == 0xC0) {
+    length = 2;
+    min_value = 0x80;
+    code_point = lead & 0x1F;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+    min_value = 0x800;
+    code_point = lead & 0x0F;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 4;
+    min_value = 0x10000;
+    code_point = lead & 0x07;
+  } else {
+    return 0;
+  }
+  if (pos + length > str.size()) return 0;
+  for (size_t i = 1; i < length; ++i) {
+    auto byte = static_cast<uint8_t>(str.at(pos + i));
+    if ((byte & 0xC0) != 0x80) return 0;
+    code_point = (code_point << 6) | (byte & 0x3F);
+  }
+  // overlong encodings, surrogates and values past the last code point are not valid UTF-8
+  if (code_point < min_value || code_point > MAX_CODE_POINT) return 0;
+  if (code_point >= SURROGATE_FIRST && code_point <= SURROGATE_LAST) return 0;
+  return length;
+}
+
+std::string encodeUtf8(uint32_t code_point) {
+  std::string ret;
+  if (code_point < 0x80) {
+    ret += static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    ret += static_cast<char>(0xC0 | (code_point >> 6));
+    ret += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    ret += static_cast<char>(0xE0 | (code_point >> 12));
+    ret += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    ret += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else {
+    ret += static_cast<char>(0xF0 | (code_point >> 18));
+    ret += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    ret += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    ret += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+  return ret;
+}
+
+void splitUtf8Range(uint32_t first, uint32_t last, std::vector<Utf8Sequence>& out) {
+  if (first > last) return;
+  if (first <= SURROGATE_LAST && last >= SURROGATE_FIRST) {
+    if (first < SURROGATE_FIRST) splitUtf8Range(first, SURROGATE_FIRST - 1, out);
+    if (last > SURROGATE_LAST) splitUtf8Range(SURROGATE_LAST + 1, last, out);
+    return;
+  }
+  // both ends have to be encoded with the same number of bytes
+  for (uint32_t max : {0x7Fu, 0x7FFu, 0xFFFFu}) {
+    if (first <= max && max < last) {
+      splitUtf8Range(first, max, out);
+      splitUtf8Range(max + 1, last, out);
+      return;
+    }
+  }
+  // every continuation byte except the ones fixed by a common prefix has to cover its full range 0x80-0xBF
+  for (uint32_t i = 1; i < 4; ++i) {
+    uint32_t mask = (1u << (6 * i)) - 1;
+    if ((first & ~mask) != (last & ~mask)) {
+      if ((first & mask) != 0) {
+        splitUtf8Range(first, first | mask, out);
+        splitUtf8Range((first | mask) + 1, last, out);
+        return;
+      }
+      if ((last & mask) != mask) {
+        splitUtf8Range(first, (last & ~mask) - 1, out);
+        splitUtf8Range(last & ~mask, last, out);
+        return;
+      }
+    }
+  }
+  auto from = encodeUtf8(first);
+  auto to = encodeUtf8(last);
+  Utf8Sequence sequence;
+  for (size_t i = 0; i < from.size(); ++i) {
+    sequence.emplace_back(static_cast<uint8_t>(from[i]), static_cast<uint8_t>(to[i]));
+  }
+  out.push_back(std::move(sequence));
+}
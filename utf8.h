@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr uint32_t MAX_CODE_POINT = 0x10FFFF;
+constexpr uint32_t SURROGATE_FIRST = 0xD800;
+constexpr uint32_t SURROGATE_LAST = 0xDFFF;
+
+// sequence of byte ranges, a string of bytes matches it if every byte is within the range at the same position
+typedef std::vector<std::pair<uint8_t, uint8_t>> Utf8Sequence;
+
+/**
+ * Function that decodes a single UTF-8 encoded code point
+ * @param str string with UTF-8 encoded text
+ * @param pos position of the first byte of the code point
+ * @param code_point set to the decoded code point
+ * @return number of bytes of the code point, or 0 if the bytes at pos are not a valid UTF-8 sequence
+ */
+size_t decodeUtf8(const std::string& str, size_t pos, uint32_t& code_point);
+
+/**
+ * Function that encodes a code point as UTF-8
+ * @param code_point code point, not a surrogate and not larger than MAX_CODE_POINT
+ * @return bytes of the encoded code point
+ */
+std::string encodeUtf8(uint32_t code_point);
+
+/**
+ * Function that splits a range of code points into sequences of byte ranges, which together match exactly the UTF-8
+ * encodings of all code points in the range. Surrogates are skipped
+ * @param first first code point of the range
+ * @param last last code point of the range
+ * @param out vector that the sequences are appended to
+ */
+void splitUtf8Range(uint32_t first, uint32_t last, std::vector<Utf8Sequence>& out);